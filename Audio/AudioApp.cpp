@@ -3,31 +3,182 @@
 #include "AudioApp.h"
 
 // Constructor
-AudioApp::AudioApp(QObject *parent) : QObject(parent), audioInput(nullptr), audioOutput(nullptr) {
-    audioInput = new AudioInput(this);
-    audioOutput = new AudioOutput(this);
+AudioApp::AudioApp(QObject *parent)
+    : QObject(parent), mediaContext(new QObject), deviceCache(nullptr), audioInput(nullptr) {
+    mediaThread.setObjectName(QStringLiteral("media"));
+    mediaContext->moveToThread(&mediaThread);
 
-    // Connect AudioInput's encoded signal to AudioOutput's addData function
-    connect(audioInput, &AudioInput::encodedAudioReady, this, &AudioApp::handleEncodedAudio);
+    // The context and everything parented to it go away with the thread
+    connect(&mediaThread, &QThread::finished, mediaContext, &QObject::deleteLater);
 }
 
 // Destructor
 AudioApp::~AudioApp() {
-    delete audioInput;
-    delete audioOutput;
+    if (mediaThread.isRunning()) {
+        QMetaObject::invokeMethod(mediaContext, [this]() { tearDownMedia(); }, Qt::BlockingQueuedConnection);
+        mediaThread.quit();
+        mediaThread.wait();
+    } else {
+        delete mediaContext;
+    }
 }
 
 // Start recording
 void AudioApp::startRecording() {
-    audioInput->startAudioCapture();
+    if (!mediaThread.isRunning()) {
+        mediaThread.start();
+    }
+    firstFrameSeen = false;
+
+    QMetaObject::invokeMethod(mediaContext, [this]() {
+        callActive = true;
+        setUpMedia();
+        if (audioInput) {
+            audioInput->startAudioCapture();
+        }
+    }, Qt::QueuedConnection);
 }
 
 // Stop recording
 void AudioApp::stopRecording() {
-    audioInput->stopAudioCapture();
+    if (!mediaThread.isRunning()) {
+        return;
+    }
+
+    QMetaObject::invokeMethod(mediaContext, [this]() {
+        callActive = false;
+        if (audioInput) {
+            audioInput->stopAudioCapture();
+        }
+    }, Qt::QueuedConnection);
+}
+
+// Enable or disable local playback of captured audio; set before recording starts
+void AudioApp::setLoopback(bool enabled) {
+    loopback = enabled;
+}
+
+// Set the receiver of encoded frames; set before recording starts
+void AudioApp::setEncodedFrameHandler(std::function<void(const AudioFrame&)> handler) {
+    encodedFrameHandler = std::move(handler);
+}
+
+// Reserve a playback stream for a new talker; stream 0 stays with loopback and untagged frames
+int AudioApp::openPlaybackStream() {
+    for (int stream = 1; stream < AudioOutput::kMaxStreams; ++stream) {
+        bool expected = false;
+        if (streamInUse[stream].compare_exchange_strong(expected, true)) {
+            if (auto output = currentOutput()) {
+                output->resetStream(stream);
+            }
+            return stream;
+        }
+    }
+    return -1;
+}
+
+void AudioApp::closePlaybackStream(int stream) {
+    if (stream > 0 && stream < AudioOutput::kMaxStreams) {
+        streamInUse[stream] = false;
+    }
+}
+
+// Play a frame that arrived from the network
+void AudioApp::playEncodedFrame(FrameHandle encodedFrame) {
+    playEncodedFrame(0, std::move(encodedFrame));
+}
+
+void AudioApp::playEncodedFrame(int stream, FrameHandle encodedFrame) {
+    auto output = currentOutput();
+    if (output) {
+        output->addFrame(stream, std::move(encodedFrame));
+        return;
+    }
+
+    // No output yet, or it was torn down after a device change: set media up again once.
+    // This frame is dropped; the ones after it play on the new output.
+    if (!setUpQueued.exchange(true)) {
+        if (!mediaThread.isRunning()) {
+            mediaThread.start();
+        }
+        QMetaObject::invokeMethod(mediaContext, [this]() { setUpMedia(); }, Qt::QueuedConnection);
+    }
+}
+
+// The output as of now; the copy stays valid even if the media thread replaces it meanwhile
+std::shared_ptr<AudioOutput> AudioApp::currentOutput() const {
+    return std::atomic_load(&audioOutput);
+}
+
+// Snapshot of the encoder controller; empty until the first call has been set up
+EncoderStats AudioApp::encoderStats() const {
+    QMutexLocker locker(&statsMutex);
+    return encoderController ? encoderController->snapshot() : EncoderStats();
+}
+
+// Runs on the media thread: enumerate devices and create codecs and sinks on first use
+void AudioApp::setUpMedia() {
+    if (!deviceCache) {
+        deviceCache = new AudioDeviceCache(mediaContext);
+        connect(deviceCache, &AudioDeviceCache::devicesChanged, mediaContext, [this]() { handleDevicesChanged(); });
+    }
+
+    setUpQueued = false;
+    if (!audioInput) {
+        activeInput = deviceCache->defaultInput();
+        activeOutput = deviceCache->defaultOutput();
+
+        // Deleted on the media thread even when a network thread drops the last reference
+        std::atomic_store(&audioOutput, std::shared_ptr<AudioOutput>(new AudioOutput(activeOutput),
+                                                                     [](AudioOutput* output) { output->deleteLater(); }));
+        audioInput = new AudioInput(activeInput);
+
+        // Hand encoded frames straight to AudioOutput from the codec worker, without a queued copy
+        audioInput->setEncodedFrameSink([this](FrameHandle frame) { handleEncodedAudio(std::move(frame)); });
+
+        QMutexLocker locker(&statsMutex);
+        encoderController = audioInput->encoderController();
+    }
+}
+
+// Runs on the media thread: destroy codecs and sinks; the device cache stays.
+// Threads still holding the output finish with it before it is deleted.
+void AudioApp::tearDownMedia() {
+    delete audioInput;
+    audioInput = nullptr;
+    std::atomic_store(&audioOutput, std::shared_ptr<AudioOutput>());
+}
+
+// Runs on the media thread: follow the default devices. A lost device changes the default too,
+// so a call in progress moves to the new defaults instead of staying silent.
+void AudioApp::handleDevicesChanged() {
+    if (!audioInput) {
+        return; // Nothing built yet; the next call or frame uses the new defaults
+    }
+    if (deviceCache->defaultInput() == activeInput && deviceCache->defaultOutput() == activeOutput) {
+        return;
+    }
+
+    tearDownMedia();
+    if (callActive) {
+        setUpMedia();
+        if (audioInput) {
+            audioInput->startAudioCapture();
+        }
+    }
 }
 
-// Slot to handle encoded audio and send to AudioOutput for playback
-void AudioApp::handleEncodedAudio(const QByteArray& encodedData) {
-    audioOutput->addData(encodedData);
+// Handle encoded audio: hand it to the network handler and, in loopback, to AudioOutput
+void AudioApp::handleEncodedAudio(FrameHandle encodedFrame) {
+    if (!firstFrameSeen.exchange(true)) {
+        emit firstFrameEncoded();
+    }
+    if (encodedFrameHandler) {
+        encodedFrameHandler(*encodedFrame);
+    }
+    if (loopback) {
+        if (auto output = currentOutput()) {
+            output->addFrame(std::move(encodedFrame));
+        }
+    }
 }
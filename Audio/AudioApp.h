@@ -3,7 +3,14 @@
 #ifndef AUDIOAPP_H
 #define AUDIOAPP_H
 
+#include <QMutex>
 #include <QObject>
+#include <QThread>
+#include <array>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include "AudioDeviceCache.h"
 #include "AudioInput.h"
 #include "AudioOutput.h"
 
@@ -11,18 +18,60 @@ class AudioApp : public QObject
 {
     Q_OBJECT
 public:
+    // Cheap: devices, codecs and sinks are only created when the first call starts
     explicit AudioApp(QObject *parent = nullptr);
     ~AudioApp();
 
-    void startRecording();
-    void stopRecording();
+    // Start a call; setup runs on the media thread and this returns immediately
+    Q_INVOKABLE void startRecording();
+    Q_INVOKABLE void stopRecording();
 
-private slots:
-    void handleEncodedAudio(const QByteArray& encodedData);
+    // Play captured audio locally (the default); endpoints that only talk to peers turn this off
+    void setLoopback(bool enabled);
+
+    // Called on a codec worker for every encoded frame, e.g. to send it to peers
+    void setEncodedFrameHandler(std::function<void(const AudioFrame&)> handler);
+
+    // One playback stream per remote talker keeps their decoders apart; the streams are mixed.
+    // Returns -1 when every stream is taken. Callable from any thread.
+    int openPlaybackStream();
+    void closePlaybackStream(int stream);
+
+    // Queue an encoded frame received from a peer for playback, on stream 0 or on an open stream
+    void playEncodedFrame(FrameHandle encodedFrame);
+    void playEncodedFrame(int stream, FrameHandle encodedFrame);
+
+    // Encoder timings and complexity of the current (or last) call; callable from any thread
+    EncoderStats encoderStats() const;
+
+signals:
+    // First frame of a call has been encoded; used for time-to-first-frame measurements
+    void firstFrameEncoded();
 
 private:
+    void setUpMedia();
+    void tearDownMedia();
+    void handleDevicesChanged();
+    void handleEncodedAudio(FrameHandle encodedFrame);
+    std::shared_ptr<AudioOutput> currentOutput() const;
+
+    QThread mediaThread;       // Owns device, codec and sink setup and their callbacks
+    QObject* mediaContext;     // Lives on mediaThread; target for queued setup work
+    AudioDeviceCache* deviceCache;
     AudioInput* audioInput;
-    AudioOutput* audioOutput;
+    // Read on network and codec threads; only ever accessed through std::atomic_load/atomic_store,
+    // so a caller's copy keeps the output alive while the media thread replaces it
+    std::shared_ptr<AudioOutput> audioOutput;
+    QAudioDevice activeInput;  // Devices the current media was built on; media thread only
+    QAudioDevice activeOutput;
+    bool callActive = false;   // Capture requested; media thread only
+    std::atomic<bool> setUpQueued{false}; // A frame arrived with no output and asked for setup
+    std::atomic<bool> firstFrameSeen{false};
+    std::array<std::atomic<bool>, AudioOutput::kMaxStreams> streamInUse{}; // Stream 0 is never handed out
+    mutable QMutex statsMutex;
+    std::shared_ptr<const ComplexityController> encoderController; // Outlives audioInput so stats stay readable
+    bool loopback = true;
+    std::function<void(const AudioFrame&)> encodedFrameHandler;
 };
 
 #endif // AUDIOAPP_H
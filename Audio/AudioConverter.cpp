@@ -0,0 +1,135 @@
+// AudioConverter.cpp
+
+#include "AudioConverter.h"
+#include "SampleKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// Constructor
+AudioConverter::AudioConverter(const QAudioFormat& from, const QAudioFormat& to, int maxInputFrames)
+    : from(from), to(to), maxInputFrames(maxInputFrames),
+      passthrough(from == to),
+      resampler(from.sampleRate(), to.sampleRate(), maxInputFrames)
+{
+    const int maxOutputFrames = resampler.maxOutputFrames(maxInputFrames);
+    interleaved.resize(maxInputFrames * from.channelCount());
+    mono.resize(maxInputFrames);
+    resampled.resize(maxOutputFrames);
+    mixed.resize(maxOutputFrames * to.channelCount());
+}
+
+bool AudioConverter::isPassthrough() const
+{
+    return passthrough;
+}
+
+int AudioConverter::maxInputBytes() const
+{
+    return maxInputFrames * from.bytesPerFrame();
+}
+
+int AudioConverter::maxOutputBytes() const
+{
+    return resampler.maxOutputFrames(maxInputFrames) * to.bytesPerFrame();
+}
+
+int AudioConverter::convert(const char* in, int inputBytes, char* out)
+{
+    const int inputFrames = std::min(inputBytes / from.bytesPerFrame(), maxInputFrames);
+    if (passthrough) {
+        std::memcpy(out, in, inputFrames * from.bytesPerFrame());
+        return inputFrames * from.bytesPerFrame();
+    }
+
+    const int fromChannels = from.channelCount();
+    const int toChannels = to.channelCount();
+
+    // Native samples -> float, then down to the mono domain the resampler works in
+    if (fromChannels == 1) {
+        toFloat(in, mono.data(), inputFrames);
+    } else {
+        toFloat(in, interleaved.data(), inputFrames * fromChannels);
+        SampleKernels::downmixToMono(interleaved.data(), mono.data(), inputFrames, fromChannels);
+    }
+
+    const int outputFrames = resampler.process(mono.data(), inputFrames, resampled.data());
+
+    // Back up to the target channel count and sample format
+    if (toChannels == 1) {
+        fromFloat(resampled.data(), out, outputFrames);
+    } else {
+        SampleKernels::upmixFromMono(resampled.data(), mixed.data(), outputFrames, toChannels);
+        fromFloat(mixed.data(), out, outputFrames * toChannels);
+    }
+    return outputFrames * to.bytesPerFrame();
+}
+
+double AudioConverter::latencyMs() const
+{
+    return resampler.latency() * 1000.0;
+}
+
+const QAudioFormat& AudioConverter::sourceFormat() const
+{
+    return from;
+}
+
+const QAudioFormat& AudioConverter::targetFormat() const
+{
+    return to;
+}
+
+void AudioConverter::toFloat(const char* in, float* out, int samples) const
+{
+    switch (from.sampleFormat()) {
+    case QAudioFormat::Int16:
+        SampleKernels::int16ToFloat(reinterpret_cast<const int16_t*>(in), out, samples);
+        break;
+    case QAudioFormat::Float:
+        std::memcpy(out, in, samples * sizeof(float));
+        break;
+    case QAudioFormat::Int32: {
+        const int32_t* source = reinterpret_cast<const int32_t*>(in);
+        for (int i = 0; i < samples; ++i)
+            out[i] = source[i] * (1.0f / 2147483648.0f);
+        break;
+    }
+    case QAudioFormat::UInt8: {
+        const uint8_t* source = reinterpret_cast<const uint8_t*>(in);
+        for (int i = 0; i < samples; ++i)
+            out[i] = (source[i] - 128) * (1.0f / 128.0f);
+        break;
+    }
+    default:
+        std::fill(out, out + samples, 0.0f);
+        break;
+    }
+}
+
+void AudioConverter::fromFloat(const float* in, char* out, int samples) const
+{
+    switch (to.sampleFormat()) {
+    case QAudioFormat::Int16:
+        SampleKernels::floatToInt16(in, reinterpret_cast<int16_t*>(out), samples);
+        break;
+    case QAudioFormat::Float:
+        std::memcpy(out, in, samples * sizeof(float));
+        break;
+    case QAudioFormat::Int32: {
+        int32_t* target = reinterpret_cast<int32_t*>(out);
+        for (int i = 0; i < samples; ++i)
+            target[i] = static_cast<int32_t>(std::clamp(in[i], -1.0f, 1.0f) * 2147483520.0f);
+        break;
+    }
+    case QAudioFormat::UInt8: {
+        uint8_t* target = reinterpret_cast<uint8_t*>(out);
+        for (int i = 0; i < samples; ++i)
+            target[i] = static_cast<uint8_t>(std::lround(std::clamp(in[i], -1.0f, 1.0f) * 127.0f) + 128);
+        break;
+    }
+    default:
+        std::memset(out, 0, samples * to.bytesPerSample());
+        break;
+    }
+}
@@ -0,0 +1,55 @@
+// AudioConverter.h
+
+#ifndef AUDIOCONVERTER_H
+#define AUDIOCONVERTER_H
+
+#include <QAudioFormat>
+#include <vector>
+#include "PolyphaseResampler.h"
+
+// Converts interleaved PCM between a device's native format and the call format
+// (48 kHz mono Int16 on one side). Samples go through float, are mixed down to mono,
+// resampled and mixed back up to the destination channel count.
+// All scratch memory is sized in the constructor, so convert() never allocates.
+class AudioConverter
+{
+public:
+    AudioConverter(const QAudioFormat& from, const QAudioFormat& to, int maxInputFrames);
+
+    // True when both formats are identical and data can be used as-is
+    bool isPassthrough() const;
+
+    // Largest input block, in bytes, accepted by one convert() call
+    int maxInputBytes() const;
+
+    // Output capacity needed for maxInputBytes() of input
+    int maxOutputBytes() const;
+
+    // Converts whole input frames; a trailing partial frame is ignored, so callers that
+    // receive arbitrary byte counts must carry it over themselves.
+    // Returns the number of bytes written to out.
+    int convert(const char* in, int inputBytes, char* out);
+
+    // Delay added by resampling, in milliseconds
+    double latencyMs() const;
+
+    const QAudioFormat& sourceFormat() const;
+    const QAudioFormat& targetFormat() const;
+
+private:
+    void toFloat(const char* in, float* out, int samples) const;
+    void fromFloat(const float* in, char* out, int samples) const;
+
+    QAudioFormat from;
+    QAudioFormat to;
+    int maxInputFrames;
+    bool passthrough;
+    PolyphaseResampler resampler;
+
+    std::vector<float> interleaved; // Source samples as float
+    std::vector<float> mono;        // Mixed down source
+    std::vector<float> resampled;   // Mono at the target rate
+    std::vector<float> mixed;       // Target channels as float
+};
+
+#endif // AUDIOCONVERTER_H
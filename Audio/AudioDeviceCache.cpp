@@ -0,0 +1,48 @@
+// AudioDeviceCache.cpp
+
+#include "AudioDeviceCache.h"
+#include <QMediaDevices>
+#include <QMutexLocker>
+
+// Constructor
+AudioDeviceCache::AudioDeviceCache(QObject *parent)
+    : QObject(parent), mediaDevices(new QMediaDevices(this))
+{
+    refreshInputs();
+    refreshOutputs();
+
+    connect(mediaDevices, &QMediaDevices::audioInputsChanged, this, [this]() {
+        refreshInputs();
+        emit devicesChanged();
+    });
+    connect(mediaDevices, &QMediaDevices::audioOutputsChanged, this, [this]() {
+        refreshOutputs();
+        emit devicesChanged();
+    });
+}
+
+QAudioDevice AudioDeviceCache::defaultInput() const
+{
+    QMutexLocker locker(&mutex);
+    return input;
+}
+
+QAudioDevice AudioDeviceCache::defaultOutput() const
+{
+    QMutexLocker locker(&mutex);
+    return output;
+}
+
+void AudioDeviceCache::refreshInputs()
+{
+    QAudioDevice device = QMediaDevices::defaultAudioInput();
+    QMutexLocker locker(&mutex);
+    input = device;
+}
+
+void AudioDeviceCache::refreshOutputs()
+{
+    QAudioDevice device = QMediaDevices::defaultAudioOutput();
+    QMutexLocker locker(&mutex);
+    output = device;
+}
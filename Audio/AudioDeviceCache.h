@@ -0,0 +1,36 @@
+// AudioDeviceCache.h
+
+#ifndef AUDIODEVICECACHE_H
+#define AUDIODEVICECACHE_H
+
+#include <QObject>
+#include <QAudioDevice>
+#include <QMutex>
+
+class QMediaDevices;
+
+// Remembers the default input and output devices so a call does not have to
+// enumerate them again. The cache is refreshed when QMediaDevices reports a change.
+class AudioDeviceCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit AudioDeviceCache(QObject *parent = nullptr);
+
+    QAudioDevice defaultInput() const;
+    QAudioDevice defaultOutput() const;
+
+signals:
+    void devicesChanged();
+
+private:
+    void refreshInputs();
+    void refreshOutputs();
+
+    QMediaDevices* mediaDevices; // Source of change notifications
+    QAudioDevice input;
+    QAudioDevice output;
+    mutable QMutex mutex; // Read from the UI thread, written on the media thread
+};
+
+#endif // AUDIODEVICECACHE_H
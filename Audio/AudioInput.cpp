@@ -3,12 +3,21 @@
 #include "AudioInput.h"
 #include <QDebug>
 #include <QAudioFormat>
-#include <QMediaDevices>
+#include <QMetaMethod>
+#include <cstring>
 #include <opus.h> // Ensure opus.h is included
 
-AudioInput::AudioInput(QObject *parent)
-    : QIODevice(parent), buffer(), opusEncoder(nullptr), audioSource(nullptr), inputDevice(nullptr)
+AudioInput::AudioInput(const QAudioDevice& inputDeviceInfo, QObject *parent)
+    : QIODevice(parent), framePool(FramePool::create(64)), opusEncoder(nullptr), audioSource(nullptr),
+      captureChain(960), captureMeter(nullptr), encodeStrand(CodecExecutor::instance().createStrand()),
+      complexityController(std::make_shared<ComplexityController>())
 {
+    // Clean up the microphone signal before Opus sees it
+    captureChain.add<HighPassFilter>(80.0f, sampleRate);
+    captureChain.add<AutomaticGainControl>(sampleRate);
+    captureChain.add<Limiter>(sampleRate);
+    captureMeter = captureChain.add<LevelMeter>();
+
     // Create Opus encoder
     int error;
     opusEncoder = opus_encoder_create(sampleRate, channels, OPUS_APPLICATION_VOIP, &error);
@@ -17,6 +26,8 @@ AudioInput::AudioInput(QObject *parent)
         return;
     }
     opus_encoder_ctl(opusEncoder, OPUS_SET_BITRATE(bitrate));
+    appliedComplexity = complexityController->complexity();
+    opus_encoder_ctl(opusEncoder, OPUS_SET_COMPLEXITY(appliedComplexity));
 
     // Configure audio format
     QAudioFormat format;
@@ -25,21 +36,45 @@ AudioInput::AudioInput(QObject *parent)
     format.setSampleFormat(QAudioFormat::Int16);
     // Note: In Qt 6.5, setCodec, setByteOrder, and setSampleType are not available
 
-    // Check if the audio format is supported by the default input device
-    QAudioDevice inputDeviceInfo = QMediaDevices::defaultAudioInput(); // Updated
-    if (!inputDeviceInfo.isFormatSupported(format)) {
-        qWarning() << "Audio format not supported by input device!";
+    // Check if the audio format is supported by the input device
+    QAudioFormat deviceFormat = format;
+    if (inputDeviceInfo.isNull()) {
+        // No device: the owner writes call-format PCM into this QIODevice itself
+        qInfo() << "No input device; capture only through write()";
+    } else if (!inputDeviceInfo.isFormatSupported(format)) {
+        // Capture in the device's native format and convert in-process instead of giving up
+        deviceFormat = inputDeviceInfo.preferredFormat();
+        if (!deviceFormat.isValid()) {
+            qWarning() << "Audio format not supported by input device!";
+            return;
+        }
+        qInfo() << "Input device captures" << deviceFormat.sampleRate() << "Hz,"
+                << deviceFormat.channelCount() << "channel(s), format" << deviceFormat.sampleFormat();
+    }
+
+    // One 20 ms block of device audio per conversion keeps the scratch buffers small
+    captureConverter = std::make_unique<AudioConverter>(deviceFormat, format, deviceFormat.sampleRate() / 50);
+    convertedBuffer.resize(captureConverter->maxOutputBytes());
+    if (!captureConverter->isPassthrough()) {
+        qInfo() << "Capture conversion adds" << captureConverter->latencyMs() << "ms of latency";
+    }
+
+    if (deviceFormat.bytesPerFrame() > kMaxDeviceFrameBytes) {
+        qWarning() << "Input device frames are too large:" << deviceFormat.bytesPerFrame() << "bytes";
         return;
     }
 
     // Create audio source
-    audioSource = new QAudioSource(format, this);
-    open(QIODevice::WriteOnly); // Open QIODevice for writing
+    if (!inputDeviceInfo.isNull()) {
+        audioSource = new QAudioSource(inputDeviceInfo, deviceFormat, this);
+    }
+    open(QIODevice::WriteOnly | QIODevice::Unbuffered); // Writes go straight to writeData
 }
 
 AudioInput::~AudioInput()
 {
     stopAudioCapture();
+    encodeStrand->close(); // No encode job may touch the encoder after this point
     if (opusEncoder) {
         opus_encoder_destroy(opusEncoder);
     }
@@ -50,17 +85,20 @@ bool AudioInput::startAudioCapture()
     if (!audioSource)
         return false;
 
-    inputDevice = audioSource->start();
-    if (!inputDevice) {
+    // Every call starts from full quality with fresh statistics; encode jobs pick the value up
+    complexityController->reset();
+    {
+        QMutexLocker locker(&mutex);
+        partialFrameSize = 0; // A new stream starts on a frame boundary
+    }
+
+    // Push mode: the source writes straight into writeData, no intermediate readAll() copy
+    audioSource->start(this);
+    if (audioSource->error() != QAudio::NoError) {
         qWarning() << "Failed to start QAudioSource!";
         return false;
     }
 
-    connect(inputDevice, &QIODevice::readyRead, this, [this]() {
-        QByteArray audioData = inputDevice->readAll();
-        writeData(audioData.data(), audioData.size());
-    });
-
     return true;
 }
 
@@ -71,42 +109,170 @@ void AudioInput::stopAudioCapture()
     }
 }
 
+bool AudioInput::isCapturing() const
+{
+    return audioSource && audioSource->state() != QAudio::StoppedState;
+}
+
+void AudioInput::setEncodedFrameSink(std::function<void(FrameHandle)> sink)
+{
+    encodedFrameSink = std::move(sink);
+}
+
+int AudioInput::droppedFrames() const
+{
+    return dropped.load();
+}
+
+EncoderStats AudioInput::encoderStats() const
+{
+    return complexityController->snapshot();
+}
+
+std::shared_ptr<const ComplexityController> AudioInput::encoderController() const
+{
+    return complexityController;
+}
+
+DspChain& AudioInput::processing()
+{
+    return captureChain;
+}
+
+const LevelMeter* AudioInput::inputLevel() const
+{
+    return captureMeter;
+}
+
 qint64 AudioInput::writeData(const char *data, qint64 len)
 {
     QMutexLocker locker(&mutex); // Lock for thread safety
 
-    buffer.append(data, len); // Add data to internal buffer
+    // The newest sample in this write was captured about now; older ones are dated back from it
+    const auto arrival = CodecStrand::Clock::now();
+    const QAudioFormat& deviceFormat = captureConverter->sourceFormat();
 
+    if (captureConverter->isPassthrough()) {
+        appendPcm(data, len, arrival);
+        return len;
+    }
+
+    // Finish a device frame left over from the previous write; it must not be dropped,
+    // or every later sample would land on the wrong channel
+    const int frameBytes = deviceFormat.bytesPerFrame();
+    qint64 offset = 0;
+    if (partialFrameSize > 0) {
+        const int needed = static_cast<int>(qMin<qint64>(frameBytes - partialFrameSize, len));
+        std::memcpy(partialFrame + partialFrameSize, data, needed);
+        partialFrameSize += needed;
+        offset = needed;
+        if (partialFrameSize < frameBytes)
+            return len;
+
+        const int converted = captureConverter->convert(partialFrame, frameBytes, convertedBuffer.data());
+        appendPcm(convertedBuffer.data(), converted,
+                  arrival - std::chrono::microseconds(deviceFormat.durationForBytes(static_cast<qint32>(len - offset))));
+        partialFrameSize = 0;
+    }
+
+    // Convert whole frames in blocks no larger than the converter was sized for
+    const int blockBytes = captureConverter->maxInputBytes();
+    const qint64 wholeFramesEnd = offset + (len - offset) / frameBytes * frameBytes;
+    while (offset < wholeFramesEnd) {
+        const int inputBytes = static_cast<int>(qMin<qint64>(blockBytes, wholeFramesEnd - offset));
+        const int converted = captureConverter->convert(data + offset, inputBytes, convertedBuffer.data());
+        offset += inputBytes;
+        const auto blockEnd = arrival - std::chrono::microseconds(
+            deviceFormat.durationForBytes(static_cast<qint32>(len - offset)));
+        appendPcm(convertedBuffer.data(), converted, blockEnd);
+    }
+
+    // Keep the trailing partial frame for the next write
+    partialFrameSize = static_cast<int>(len - wholeFramesEnd);
+    std::memcpy(partialFrame, data + wholeFramesEnd, partialFrameSize);
+
+    return len;
+}
+
+// Splits 48kHz mono Int16 audio into 20 ms frames and queues them for encoding.
+// captureEnd is when the last sample in data was captured.
+void AudioInput::appendPcm(const char *data, qint64 len, CodecStrand::Clock::time_point captureEnd)
+{
     // Each frame requires 960 samples for 20 ms at a 48kHz sample rate
     const int frameSize = 960 * channels; // 960 samples
     const int bytesPerSample = sizeof(opus_int16); // 2 bytes per sample
     const int bytesPerFrame = frameSize * bytesPerSample; // 1920 bytes
 
-    while (buffer.size() >= bytesPerFrame) {
-        QByteArray frameData = buffer.left(bytesPerFrame);
-        buffer.remove(0, bytesPerFrame);
-
-        QByteArray encodedData;
-        // Use opus_encode_bound to reserve sufficient space
-        // If opus_encode_bound is unavailable, use an approximate value
-        // int bound = opus_encode_bound(opusEncoder, frameSize); // if available
-        int bound = frameSize * bytesPerSample; // Approximate value
-        encodedData.resize(bound);
-
-        int encodedBytes = opus_encode(opusEncoder,
-                                       reinterpret_cast<const opus_int16*>(frameData.constData()),
-                                       frameSize,
-                                       reinterpret_cast<unsigned char*>(encodedData.data()),
-                                       bound);
-
-        if (encodedBytes < 0) {
-            qDebug() << "Encoding failed with error:" << opus_strerror(encodedBytes);
-            continue;
+    qint64 consumed = 0;
+    while (consumed < len) {
+        if (!captureFrame) {
+            captureFrame = framePool->acquire();
+            if (!captureFrame) {
+                // Every frame is in flight; drop this chunk rather than allocate
+                dropped.fetch_add(1);
+                break;
+            }
+        }
+
+        const int chunk = static_cast<int>(qMin<qint64>(bytesPerFrame - captureFrame->size, len - consumed));
+        std::memcpy(captureFrame->data + captureFrame->size, data + consumed, chunk);
+        captureFrame->size += chunk;
+        consumed += chunk;
+
+        if (captureFrame->size == bytesPerFrame) {
+            // Date the frame by its last sample; it has to be encoded before the next frame is complete
+            const qint64 laterSamples = (len - consumed) / bytesPerSample;
+            captureFrame->timestamp = captureEnd - std::chrono::microseconds(laterSamples * 1000000 / sampleRate);
+            captureFrame->readyTime = CodecStrand::Clock::now();
+            const auto deadline = captureFrame->timestamp + std::chrono::milliseconds(20);
+            encodeStrand->post(&AudioInput::encodeFrame, this, std::move(captureFrame), deadline);
         }
+    }
+}
+
+// Runs on a codec worker; the strand guarantees frames are encoded one at a time and in order
+void AudioInput::encodeFrame(void* context, FrameHandle& frame)
+{
+    AudioInput* self = static_cast<AudioInput*>(context);
+    const int frameSize = 960 * self->channels; // 960 samples
 
-        encodedData.resize(encodedBytes);
-        emit encodedAudioReady(encodedData);
+    FrameHandle encoded = self->framePool->acquire();
+    if (!encoded) {
+        self->dropped.fetch_add(1);
+        return;
     }
 
-    return len;
+    opus_int16* pcm = reinterpret_cast<opus_int16*>(frame->data);
+    self->captureChain.process(pcm, frameSize); // In place, on the captured frame itself
+
+    const auto encodeStart = ComplexityController::Clock::now();
+    int encodedBytes = opus_encode(self->opusEncoder,
+                                   pcm,
+                                   frameSize,
+                                   encoded->data,
+                                   kMaxFrameBytes);
+    const auto encodeEnd = ComplexityController::Clock::now();
+
+    // Queueing, processing and encoding count against the frame's real-time budget. Time spent
+    // in the device's own buffer does not: frames of a large write start out old on an idle host.
+    const int complexity = self->complexityController->update(encodeEnd - encodeStart,
+                                                             encodeEnd - frame->readyTime);
+    if (complexity != self->appliedComplexity) {
+        opus_encoder_ctl(self->opusEncoder, OPUS_SET_COMPLEXITY(complexity)); // Counted in encoderStats(), not logged
+        self->appliedComplexity = complexity;
+    }
+
+    if (encodedBytes < 0) {
+        self->dropped.fetch_add(1); // Counted, not logged: this runs once per frame
+        return;
+    }
+    encoded->size = encodedBytes;
+    frame.reset(); // Capture frame can be reused right away
+
+    if (self->isSignalConnected(QMetaMethod::fromSignal(&AudioInput::encodedAudioReady))) {
+        emit self->encodedAudioReady(QByteArray(reinterpret_cast<const char*>(encoded->data), encoded->size));
+    }
+    if (self->encodedFrameSink) {
+        self->encodedFrameSink(std::move(encoded));
+    }
 }
@@ -4,22 +4,50 @@
 #define AUDIOINPUT_H
 
 #include <QIODevice>
+#include <QAudioDevice>
 #include <QAudioSource>
 #include <QByteArray>
 #include <QMutex>
+#include <atomic>
+#include <functional>
+#include <memory>
 #include <opus.h> // Opus library
+#include <vector>
+#include "AudioConverter.h"
+#include "CodecExecutor.h"
+#include "ComplexityController.h"
+#include "DspChain.h"
+#include "FramePool.h"
 
 class AudioInput : public QIODevice
 {
     Q_OBJECT
 public:
-    explicit AudioInput(QObject *parent = nullptr);
+    // Creates the encoder and the source; construct on the thread that will run capture
+    explicit AudioInput(const QAudioDevice& inputDeviceInfo, QObject *parent = nullptr);
     ~AudioInput();
 
     bool startAudioCapture();
     void stopAudioCapture();
+    bool isCapturing() const;
+
+    // Receives every encoded frame on a codec worker thread without copying or allocating.
+    // Set it during call setup, before capture starts.
+    void setEncodedFrameSink(std::function<void(FrameHandle)> sink);
+
+    int droppedFrames() const;
+
+    // Encode timings and the complexity the controller settled on, for the current call
+    EncoderStats encoderStats() const;
+    std::shared_ptr<const ComplexityController> encoderController() const;
+
+    // Runs on every 20 ms frame right before encoding. Defaults to high-pass, AGC, limiter
+    // and a meter; add or replace stages before capture starts.
+    DspChain& processing();
+    const LevelMeter* inputLevel() const;
 
 signals:
+    // Legacy per-frame copy; only emitted when something is connected
     void encodedAudioReady(const QByteArray& encodedData);
 
 protected:
@@ -27,10 +55,25 @@ protected:
     qint64 writeData(const char *data, qint64 len) override;
 
 private:
-    QByteArray buffer;          // Internal buffer to collect data
+    void appendPcm(const char *data, qint64 len, CodecStrand::Clock::time_point captureEnd);
+    static void encodeFrame(void* context, FrameHandle& frame);
+
+    std::shared_ptr<FramePool> framePool; // Capture and encoded frames, allocated once
+    FrameHandle captureFrame;   // Frame currently being filled from the device
     OpusEncoder* opusEncoder;   // Opus encoder
     QAudioSource* audioSource;  // Audio source
-    QIODevice* inputDevice;     // Audio input device
+    std::unique_ptr<AudioConverter> captureConverter; // Device format -> 48kHz mono Int16
+    std::vector<char> convertedBuffer; // Converter output, sized once at setup
+    static constexpr int kMaxDeviceFrameBytes = 256; // 32 channels of 64-bit samples
+    char partialFrame[kMaxDeviceFrameBytes]; // Bytes of a device frame split across writes
+    int partialFrameSize = 0;
+    DspChain captureChain;      // In-place processing between capture and encode
+    LevelMeter* captureMeter;   // Owned by captureChain
+    std::shared_ptr<CodecStrand> encodeStrand; // Serial encode queue on the shared codec pool
+    std::function<void(FrameHandle)> encodedFrameSink;
+    std::shared_ptr<ComplexityController> complexityController; // Trades quality for CPU time under load
+    int appliedComplexity = -1; // Last value given to the encoder; only touched by encode jobs
+    std::atomic<int> dropped{0}; // Frames lost to a dry pool or an encoder error
 
     const int sampleRate = 48000; // Sample rate of 48kHz
     const int channels = 1;       // Mono
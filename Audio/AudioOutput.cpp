@@ -1,97 +1,272 @@
 // AudioOutput.cpp
 
 #include "AudioOutput.h"
-#include <QMediaDevices>
 #include <QDebug>
 #include <QMutexLocker>
+#include <algorithm>
+#include <cstring>
 #include <opus.h> // Ensure opus.h is included
+#include "SampleKernels.h"
 
-AudioOutput::AudioOutput(QObject* parent)
-    : QObject(parent), audioSink(nullptr), audioDevice(nullptr), opusDecoder(nullptr)
+AudioOutput::PlaybackStream::PlaybackStream()
+    : decodeStrand(CodecExecutor::instance().createStrand()),
+      playout(48000 / 5) // Up to 200 ms of queued playout at 48kHz
 {
+}
+
+AudioOutput::AudioOutput(const QAudioDevice& outputDeviceInfo, QObject* parent)
+    : QIODevice(parent), audioSink(nullptr),
+      framePool(FramePool::create(32)),
+      playbackChain(960), playbackMeter(nullptr)
+{
+    // Keep loud or clipped remote audio, and the sum of several talkers, from distorting on the device
+    playbackChain.add<Limiter>(48000);
+    playbackMeter = playbackChain.add<LevelMeter>();
+
     // Audio format settings must match those in AudioInput
     audioFormat.setSampleRate(48000);       // 48kHz
     audioFormat.setChannelCount(1);         // Mono
     audioFormat.setSampleFormat(QAudioFormat::Int16);
     // Note: In Qt 6.5, setCodec, setByteOrder, and setSampleType are not available
 
-    // Check if the audio format is supported by the default output device
-    QAudioDevice outputDeviceInfo = QMediaDevices::defaultAudioOutput(); // Updated
-    if (!outputDeviceInfo.isFormatSupported(audioFormat)) {
-        qWarning() << "Audio format not supported by output device!";
-        return;
+    // Check if the audio format is supported by the output device
+    deviceFormat = audioFormat;
+    if (outputDeviceInfo.isNull()) {
+        // No device: the owner pulls call-format PCM from this QIODevice itself
+        qInfo() << "No output device; playback only through read()";
+    } else if (!outputDeviceInfo.isFormatSupported(audioFormat)) {
+        // Play in the device's native format and convert in-process instead of giving up
+        deviceFormat = outputDeviceInfo.preferredFormat();
+        if (!deviceFormat.isValid()) {
+            qWarning() << "Audio format not supported by output device!";
+            return;
+        }
+        qInfo() << "Output device plays" << deviceFormat.sampleRate() << "Hz,"
+                << deviceFormat.channelCount() << "channel(s), format" << deviceFormat.sampleFormat();
     }
 
-    // Set up QAudioSink for audio output
-    audioSink = new QAudioSink(outputDeviceInfo, audioFormat, this);
-    audioDevice = audioSink->start();
-    if (!audioDevice) {
-        qWarning() << "Failed to start QAudioSink!";
+    // Convert one decoded 20 ms frame at a time
+    playbackConverter = std::make_unique<AudioConverter>(audioFormat, deviceFormat, 960);
+    pullBuffer.resize(960);
+    streamBuffer.resize(960);
+    mixBuffer.resize(960);
+    convertedOutput.resize(playbackConverter->maxOutputBytes());
+    if (!playbackConverter->isPassthrough()) {
+        qInfo() << "Playback conversion adds" << playbackConverter->latencyMs() << "ms of latency";
+    }
+
+    // Initialize one Opus decoder per stream with matching settings; a shared decoder
+    // would mix up the prediction state of different talkers
+    for (PlaybackStream& stream : streams) {
+        stream.owner = this;
+        int opusError;
+        stream.opusDecoder = opus_decoder_create(48000, 1, &opusError);  // 48kHz, Mono
+        if (opusError != OPUS_OK) {
+            qWarning() << "Failed to create Opus decoder:" << opus_strerror(opusError);
+            stream.opusDecoder = nullptr;
+            return;
+        }
+    }
+
+    // Reads go straight to readData; QIODevice's own read buffer would only add a copy
+    open(QIODevice::ReadOnly | QIODevice::Unbuffered);
+    if (outputDeviceInfo.isNull()) {
         return;
     }
 
-    // Initialize Opus decoder with matching settings
-    int opusError;
-    opusDecoder = opus_decoder_create(48000, 1, &opusError);  // 48kHz, Mono
-    if (opusError != OPUS_OK) {
-        qWarning() << "Failed to create Opus decoder:" << opus_strerror(opusError);
-        opusDecoder = nullptr;
+    // Set up QAudioSink for audio output; it pulls from readData on its own schedule
+    audioSink = new QAudioSink(outputDeviceInfo, deviceFormat, this);
+    audioSink->start(this);
+    if (audioSink->error() != QAudio::NoError) {
+        qWarning() << "Failed to start QAudioSink!";
+        return;
     }
 }
 
 AudioOutput::~AudioOutput()
 {
-    if (opusDecoder) {
-        opus_decoder_destroy(opusDecoder);
+    if (audioSink) {
+        audioSink->stop();
+    }
+    for (PlaybackStream& stream : streams) {
+        stream.decodeStrand->close(); // No decode job may touch the decoder after this point
+        if (stream.opusDecoder) {
+            opus_decoder_destroy(stream.opusDecoder);
+        }
     }
     // No need to manually delete audioSink; Qt will handle it automatically
 }
 
 void AudioOutput::addData(const QByteArray& encodedData)
 {
-    QMutexLocker locker(&mutex); // Lock for thread safety
+    if (encodedData.size() > kMaxFrameBytes) {
+        dropped.fetch_add(1); // Larger than a frame buffer
+        return;
+    }
+
+    FrameHandle frame = framePool->acquire();
+    if (!frame) {
+        dropped.fetch_add(1); // Decoder is far behind; the frame would be late anyway
+        return;
+    }
+    std::memcpy(frame->data, encodedData.constData(), encodedData.size());
+    frame->size = encodedData.size();
+    addFrame(std::move(frame));
+}
+
+DspChain& AudioOutput::processing()
+{
+    return playbackChain;
+}
+
+const LevelMeter* AudioOutput::outputLevel() const
+{
+    return playbackMeter;
+}
+
+int AudioOutput::droppedFrames() const
+{
+    return dropped.load();
+}
+
+int AudioOutput::queuedSamples() const
+{
+    int samples = 0;
+    for (const PlaybackStream& stream : streams) {
+        samples += stream.playout.available();
+    }
+    return samples;
+}
+
+void AudioOutput::addFrame(FrameHandle encodedFrame)
+{
+    addFrame(0, std::move(encodedFrame));
+}
 
-    if (!audioDevice || !opusDecoder) {
-        qWarning() << "Audio device or Opus decoder is not initialized!";
+void AudioOutput::addFrame(int stream, FrameHandle encodedFrame)
+{
+    if (stream < 0 || stream >= kMaxStreams) {
         return;
     }
 
-    // Decode Opus data to PCM
-    QByteArray pcmData = decodeOpus(encodedData);
-    if (pcmData.isEmpty()) {
-        qWarning() << "Failed to decode Opus data!";
+    QMutexLocker locker(&mutex); // Lock for thread safety
+
+    if (!decodersReady()) {
+        dropped.fetch_add(1); // Setup failed and was logged once; frames only count from here
         return;
     }
 
-    // Write PCM data to the audio device
-    qint64 written = audioDevice->write(pcmData);
-    if (written != pcmData.size()) {
-        qWarning() << "Not all PCM data was written to the audio device!";
+    // The frame plays once everything queued ahead of it has played: decoded samples
+    // in the ring plus one frame per decode still waiting. That is its decode deadline.
+    PlaybackStream& target = streams[stream];
+    const int queuedSamples = target.playout.available() + target.decodeStrand->pendingJobs() * 960;
+    const auto playoutTime = CodecStrand::Clock::now() + std::chrono::microseconds(queuedSamples * 1000000LL / 48000);
+    target.decodeStrand->post(&AudioOutput::decodeFrame, &target, std::move(encodedFrame), playoutTime);
+}
+
+void AudioOutput::resetStream(int stream)
+{
+    if (stream >= 0 && stream < kMaxStreams) {
+        streams[stream].resetPending = true;
     }
-    qDebug() << "PCM data written for playback.";
 }
 
-QByteArray AudioOutput::decodeOpus(const QByteArray& encodedData)
+// Decoders are created in order and setup stops at the first failure
+bool AudioOutput::decodersReady() const
+{
+    return streams.back().opusDecoder != nullptr;
+}
+
+// Runs on a codec worker; decodes into a stack buffer and queues the samples for the sink
+void AudioOutput::decodeFrame(void* context, FrameHandle& frame)
 {
-    if (!opusDecoder) {
-        return QByteArray(); // Return empty if decoder is not initialized
+    PlaybackStream* stream = static_cast<PlaybackStream*>(context);
+    if (stream->resetPending.exchange(false)) {
+        opus_decoder_ctl(stream->opusDecoder, OPUS_RESET_STATE); // New talker on this stream
     }
 
-    // Prepare buffer for decoded PCM data
     opus_int16 pcmData[960 * 1]; // 960 samples for 20ms frame at 48kHz, mono
+    int samples = decodeOpus(stream->opusDecoder, frame->data, frame->size, pcmData, 960);
+    if (samples <= 0) {
+        stream->owner->dropped.fetch_add(1);
+        return;
+    }
+
+    if (stream->playout.write(pcmData, samples) != samples) {
+        stream->owner->dropped.fetch_add(1); // Playout buffer full; counted, not logged
+    }
+}
+
+qint64 AudioOutput::readData(char *data, qint64 maxlen)
+{
+    // Only hand out whole device frames so channels never shift
+    maxlen -= maxlen % deviceFormat.bytesPerFrame();
+
+    qint64 produced = 0;
+    if (playbackConverter->isPassthrough()) {
+        opus_int16* out = reinterpret_cast<opus_int16*>(data);
+        const int requested = static_cast<int>(maxlen / sizeof(opus_int16));
+        int samples = 0;
+        while (samples < requested) {
+            const int chunk = qMin(requested - samples, static_cast<int>(pullBuffer.size()));
+            const int mixed = mix(out + samples, chunk);
+            samples += mixed;
+            if (mixed < chunk)
+                break;
+        }
+        produced = samples * sizeof(opus_int16);
+    } else {
+        while (produced < maxlen) {
+            if (convertedOffset == convertedSize) {
+                const int samples = mix(pullBuffer.data(), static_cast<int>(pullBuffer.size()));
+                if (samples == 0)
+                    break;
+                convertedSize = playbackConverter->convert(reinterpret_cast<const char*>(pullBuffer.data()),
+                                                           samples * sizeof(opus_int16), convertedOutput.data());
+                convertedOffset = 0;
+            }
+
+            const int chunk = static_cast<int>(qMin<qint64>(convertedSize - convertedOffset, maxlen - produced));
+            std::memcpy(data + produced, convertedOutput.data() + convertedOffset, chunk);
+            convertedOffset += chunk;
+            produced += chunk;
+        }
+    }
+
+    // Fill gaps with silence so the sink keeps running through network jitter
+    const char silence = (deviceFormat.sampleFormat() == QAudioFormat::UInt8) ? char(0x80) : 0;
+    std::memset(data + produced, silence, maxlen - produced);
+    return maxlen;
+}
+
+// Sums up to count samples (at most one frame) of every stream as float, runs the playback
+// chain on the unclipped sum so the limiter sees its real peaks, then saturates once into out.
+// Returns the length of the longest stream's part.
+int AudioOutput::mix(opus_int16* out, int count)
+{
+    constexpr float kScale = 1.0f / 32768.0f;
+
+    std::fill_n(mixBuffer.begin(), count, 0.0f);
+    int mixed = 0;
+    for (PlaybackStream& stream : streams) {
+        const int samples = stream.playout.read(streamBuffer.data(), count);
+        for (int i = 0; i < samples; ++i) {
+            mixBuffer[i] += streamBuffer[i] * kScale;
+        }
+        mixed = std::max(mixed, samples);
+    }
+
+    playbackChain.process(mixBuffer.data(), mixed);
+    SampleKernels::floatToInt16(mixBuffer.data(), out, mixed);
+    return mixed;
+}
 
-    // Decode Opus data
-    int frameSize = opus_decode(opusDecoder,
-                                reinterpret_cast<const unsigned char*>(encodedData.constData()),
-                                encodedData.size(),
-                                pcmData,
-                                960,
-                                0);
-    if (frameSize < 0) {
-        qWarning() << "Opus decoding failed with error:" << opus_strerror(frameSize);
-        return QByteArray();
+int AudioOutput::decodeOpus(OpusDecoder* decoder, const unsigned char* packet, int packetSize, opus_int16* pcm, int maxSamples)
+{
+    if (!decoder) {
+        return -1; // Decoder is not initialized
     }
 
-    // Convert PCM data to QByteArray
-    return QByteArray(reinterpret_cast<const char*>(pcmData), frameSize * sizeof(opus_int16));
+    // Decode Opus data; failures are counted by the caller, this runs once per frame
+    return opus_decode(decoder, packet, packetSize, pcm, maxSamples, 0);
 }
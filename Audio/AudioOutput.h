@@ -3,30 +3,93 @@
 #ifndef AUDIOOUTPUT_H
 #define AUDIOOUTPUT_H
 
-#include <QObject>
+#include <QIODevice>
+#include <QAudioDevice>
 #include <QAudioSink>
 #include <QByteArray>
 #include <QMutex>
+#include <array>
+#include <atomic>
+#include <memory>
+#include <vector>
 #include <opus.h> // Opus library
+#include "AudioConverter.h"
+#include "CodecExecutor.h"
+#include "DspChain.h"
+#include "FramePool.h"
+#include "PcmRingBuffer.h"
 
-class AudioOutput : public QObject
+class AudioOutput : public QIODevice
 {
     Q_OBJECT
 public:
-    explicit AudioOutput(QObject *parent = nullptr);
+    // Creates the decoder and starts the sink; construct on the thread that will run playback
+    explicit AudioOutput(const QAudioDevice& outputDeviceInfo, QObject *parent = nullptr);
     ~AudioOutput();
 
+    // Each remote talker plays on its own stream with its own decoder and playout ring;
+    // the sink mixes all of them. Stream 0 takes frames that name no stream.
+    static constexpr int kMaxStreams = 8;
+
     void addData(const QByteArray& encodedData);
+    // Zero-copy entry points for frames that already live in a FramePool
+    void addFrame(FrameHandle encodedFrame);
+    void addFrame(int stream, FrameHandle encodedFrame);
+
+    // Forget a stream's decoder state before it carries a new talker; callable from any thread
+    void resetStream(int stream);
+
+    // Runs on the mixed audio before it goes to the sink. Defaults to a limiter
+    // and a meter; add or replace stages before frames arrive.
+    DspChain& processing();
+    const LevelMeter* outputLevel() const;
+
+    // Frames lost to a full pool or playout ring, or to decode errors; counted instead of logged
+    int droppedFrames() const;
+    // Decoded samples of all streams waiting for the sink
+    int queuedSamples() const;
+
+protected:
+    // Pull mode: the sink reads decoded PCM straight from the playout ring
+    qint64 readData(char *data, qint64 maxlen) override;
+    qint64 writeData(const char *data, qint64 len) override { Q_UNUSED(data); Q_UNUSED(len); return -1; }
 
 private:
+    // One remote talker; decode jobs on its strand are its only producer, the sink its only consumer
+    struct PlaybackStream
+    {
+        PlaybackStream();
+
+        AudioOutput* owner = nullptr;
+        OpusDecoder* opusDecoder = nullptr;
+        std::shared_ptr<CodecStrand> decodeStrand; // Serial decode queue on the shared codec pool
+        PcmRingBuffer playout;                     // Decoded samples waiting for the sink
+        std::atomic<bool> resetPending{false};     // Applied by the next decode job
+    };
+
     QAudioSink* audioSink;       // Audio output device
-    QIODevice* audioDevice;      // Audio writing device
-    OpusDecoder* opusDecoder;    // Opus decoder
+    std::array<PlaybackStream, kMaxStreams> streams;
+    std::shared_ptr<FramePool> framePool;      // Frames for addData() copies
+    DspChain playbackChain;      // In-place processing of the mix, on the sink's thread
+    LevelMeter* playbackMeter;   // Owned by playbackChain
+
+    std::unique_ptr<AudioConverter> playbackConverter; // 48kHz mono Int16 -> device format
+    std::vector<opus_int16> pullBuffer;  // Mixed samples for one conversion
+    std::vector<opus_int16> streamBuffer; // One stream's samples while mixing
+    std::vector<float> mixBuffer;         // Sum of all streams, unclipped, for the playback chain
+    std::vector<char> convertedOutput;   // Converted bytes not yet handed to the sink
+    int convertedOffset = 0;
+    int convertedSize = 0;
 
     QAudioFormat audioFormat;    // Audio format
+    QAudioFormat deviceFormat;   // Format the sink actually runs in
     QMutex mutex;                // For thread safety
+    std::atomic<int> dropped{0};
 
-    QByteArray decodeOpus(const QByteArray& encodedData);
+    bool decodersReady() const;
+    int mix(opus_int16* out, int count);
+    static void decodeFrame(void* context, FrameHandle& frame);
+    static int decodeOpus(OpusDecoder* decoder, const unsigned char* packet, int packetSize, opus_int16* pcm, int maxSamples);
 };
 
 #endif // AUDIOOUTPUT_H
@@ -0,0 +1,222 @@
+// CodecExecutor.cpp
+
+#include "CodecExecutor.h"
+#include <QMutexLocker>
+#include <algorithm>
+
+namespace {
+
+// Worker index of the calling thread, or -1 when it is not a codec worker
+thread_local const CodecExecutor* currentExecutor = nullptr;
+thread_local int currentWorker = -1;
+
+// std::*_heap build max-heaps, so "greater deadline" keeps the earliest deadline on top
+template <typename Task>
+bool laterDeadline(const Task& a, const Task& b)
+{
+    return a.deadline > b.deadline;
+}
+
+} // namespace
+
+// Constructor
+CodecStrand::CodecStrand(CodecExecutor* executor) : executor(executor) {}
+
+void CodecStrand::post(JobFunction function, void* context, FrameHandle frame, Clock::time_point deadline)
+{
+    bool needsSchedule = false;
+    Clock::time_point firstDeadline;
+    {
+        QMutexLocker locker(&mutex);
+        if (closed)
+            return;
+
+        if (pendingCount == kMaxPendingJobs) {
+            pending[pendingHead] = PendingJob(); // Returns the dropped frame to its pool
+            pendingHead = (pendingHead + 1) % kMaxPendingJobs;
+            --pendingCount;
+        }
+
+        PendingJob& job = pending[(pendingHead + pendingCount) % kMaxPendingJobs];
+        job.function = function;
+        job.context = context;
+        job.frame = std::move(frame);
+        job.deadline = deadline;
+        ++pendingCount;
+
+        if (!scheduled) {
+            scheduled = true;
+            needsSchedule = true;
+            firstDeadline = pending[pendingHead].deadline;
+        }
+    }
+
+    // Only one task per strand is ever queued, which keeps jobs of one call in order
+    if (needsSchedule)
+        executor->schedule(shared_from_this(), firstDeadline);
+}
+
+int CodecStrand::pendingJobs() const
+{
+    QMutexLocker locker(&mutex);
+    return pendingCount;
+}
+
+void CodecStrand::close()
+{
+    QMutexLocker locker(&mutex);
+    closed = true;
+    for (; pendingCount > 0; --pendingCount) {
+        pending[pendingHead] = PendingJob();
+        pendingHead = (pendingHead + 1) % kMaxPendingJobs;
+    }
+    while (running)
+        idle.wait(&mutex);
+}
+
+void CodecStrand::runOne()
+{
+    PendingJob current;
+    {
+        QMutexLocker locker(&mutex);
+        if (closed || pendingCount == 0) {
+            scheduled = false;
+            return;
+        }
+        current = std::move(pending[pendingHead]);
+        pendingHead = (pendingHead + 1) % kMaxPendingJobs;
+        --pendingCount;
+        running = true;
+    }
+
+    current.function(current.context, current.frame);
+    current.frame.reset();
+
+    bool reschedule = false;
+    Clock::time_point nextDeadline;
+    {
+        QMutexLocker locker(&mutex);
+        running = false;
+        if (!closed && pendingCount > 0) {
+            nextDeadline = pending[pendingHead].deadline;
+            reschedule = true;
+        } else {
+            scheduled = false;
+        }
+        idle.wakeAll();
+    }
+
+    if (reschedule)
+        executor->schedule(shared_from_this(), nextDeadline);
+}
+
+// Constructor
+CodecExecutor::CodecExecutor(int workerCount)
+{
+    workerCount = std::max(1, workerCount);
+    workers.reserve(workerCount);
+    for (int i = 0; i < workerCount; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+        workers.back()->queue.reserve(kReservedTasks);
+    }
+
+    // Above normal so codec work is not queued behind background threads, but not time-critical:
+    // there is one worker per core, and at that level a busy pool could starve the audio device
+    // callbacks and the event loop that feed it frames.
+    for (int i = 0; i < workerCount; ++i) {
+        workers[i]->thread.reset(QThread::create([this, i]() { workerLoop(i); }));
+        workers[i]->thread->setObjectName(QStringLiteral("codec-worker-%1").arg(i));
+        workers[i]->thread->start(QThread::HighestPriority);
+    }
+}
+
+// Destructor
+CodecExecutor::~CodecExecutor()
+{
+    {
+        QMutexLocker locker(&sleepMutex);
+        stopping = true;
+        wakeUp.wakeAll();
+    }
+    for (auto& worker : workers)
+        worker->thread->wait();
+}
+
+// Process-wide executor shared by all calls
+CodecExecutor& CodecExecutor::instance()
+{
+    static CodecExecutor executor;
+    return executor;
+}
+
+std::shared_ptr<CodecStrand> CodecExecutor::createStrand()
+{
+    return std::shared_ptr<CodecStrand>(new CodecStrand(this));
+}
+
+int CodecExecutor::workerCount() const
+{
+    return static_cast<int>(workers.size());
+}
+
+void CodecExecutor::schedule(std::shared_ptr<CodecStrand> strand, CodecStrand::Clock::time_point deadline)
+{
+    // Rescheduling from a worker keeps the strand on the same core; new work is spread round-robin
+    const int index = (currentExecutor == this)
+                          ? currentWorker
+                          : static_cast<int>(nextWorker.fetch_add(1, std::memory_order_relaxed) % workers.size());
+
+    Worker& worker = *workers[index];
+    {
+        QMutexLocker locker(&worker.mutex);
+        worker.queue.push_back({std::move(strand), deadline});
+        std::push_heap(worker.queue.begin(), worker.queue.end(), laterDeadline<Task>);
+    }
+
+    queuedTasks.fetch_add(1);
+    QMutexLocker locker(&sleepMutex);
+    wakeUp.wakeOne();
+}
+
+bool CodecExecutor::popTask(Worker& worker, Task& task)
+{
+    QMutexLocker locker(&worker.mutex);
+    if (worker.queue.empty())
+        return false;
+
+    std::pop_heap(worker.queue.begin(), worker.queue.end(), laterDeadline<Task>);
+    task = std::move(worker.queue.back());
+    worker.queue.pop_back();
+    return true;
+}
+
+bool CodecExecutor::stealTask(int thief, Task& task)
+{
+    const int count = static_cast<int>(workers.size());
+    for (int offset = 1; offset < count; ++offset) {
+        if (popTask(*workers[(thief + offset) % count], task))
+            return true;
+    }
+    return false;
+}
+
+void CodecExecutor::workerLoop(int index)
+{
+    currentExecutor = this;
+    currentWorker = index;
+
+    for (;;) {
+        Task task;
+        if (popTask(*workers[index], task) || stealTask(index, task)) {
+            queuedTasks.fetch_sub(1);
+            task.strand->runOne();
+            continue;
+        }
+
+        QMutexLocker locker(&sleepMutex);
+        while (queuedTasks.load() == 0 && !stopping)
+            wakeUp.wait(&sleepMutex);
+        if (stopping && queuedTasks.load() == 0)
+            break;
+    }
+}
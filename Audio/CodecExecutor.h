@@ -0,0 +1,110 @@
+// CodecExecutor.h
+
+#ifndef CODECEXECUTOR_H
+#define CODECEXECUTOR_H
+
+#include <QMutex>
+#include <QThread>
+#include <QWaitCondition>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <vector>
+#include "FramePool.h"
+
+class CodecExecutor;
+
+// Serial queue of codec jobs for one call direction (e.g. the encoder of one call).
+// Jobs posted to the same strand run one at a time and in posting order,
+// while different strands are spread over the executor's worker threads.
+// A job is a plain function pointer plus the frame it works on, kept in a
+// fixed ring, so posting never allocates.
+class CodecStrand : public std::enable_shared_from_this<CodecStrand>
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using JobFunction = void (*)(void* context, FrameHandle& frame);
+
+    // Jobs that may wait in one strand; 16 frames is 320 ms of 20 ms audio
+    static constexpr int kMaxPendingJobs = 16;
+
+    // Queue a job that should be finished before the given deadline.
+    // When the ring is full the oldest job, which is already late, is dropped.
+    void post(JobFunction function, void* context, FrameHandle frame, Clock::time_point deadline);
+
+    // Drop pending jobs and wait for the running one; must not be called from a job
+    void close();
+
+    // Jobs waiting to run, not counting one that is running
+    int pendingJobs() const;
+
+private:
+    friend class CodecExecutor;
+    explicit CodecStrand(CodecExecutor* executor);
+
+    void runOne();
+
+    struct PendingJob {
+        JobFunction function = nullptr;
+        void* context = nullptr;
+        FrameHandle frame;
+        Clock::time_point deadline;
+    };
+
+    CodecExecutor* executor;
+    mutable QMutex mutex;
+    QWaitCondition idle;
+    PendingJob pending[kMaxPendingJobs];
+    int pendingHead = 0;
+    int pendingCount = 0;
+    bool scheduled = false; // Strand is sitting in a worker queue
+    bool running = false;   // A job of this strand is executing right now
+    bool closed = false;
+};
+
+// Fixed pool of codec worker threads shared by every call in the process.
+// Each worker keeps its own queue ordered by deadline and steals from the
+// others when it runs dry, so codec work scales across cores.
+class CodecExecutor
+{
+public:
+    explicit CodecExecutor(int workerCount = QThread::idealThreadCount());
+    ~CodecExecutor();
+
+    static CodecExecutor& instance();
+
+    std::shared_ptr<CodecStrand> createStrand();
+    int workerCount() const;
+
+private:
+    friend class CodecStrand;
+
+    struct Task {
+        std::shared_ptr<CodecStrand> strand;
+        CodecStrand::Clock::time_point deadline;
+    };
+
+    // Queue slots reserved per worker so scheduling does not allocate
+    static constexpr int kReservedTasks = 256;
+
+    struct Worker {
+        QMutex mutex;
+        std::vector<Task> queue; // Min-heap on deadline
+        std::unique_ptr<QThread> thread;
+    };
+
+    void schedule(std::shared_ptr<CodecStrand> strand, CodecStrand::Clock::time_point deadline);
+    bool popTask(Worker& worker, Task& task);
+    bool stealTask(int thief, Task& task);
+    void workerLoop(int index);
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::atomic<unsigned> nextWorker{0};
+    std::atomic<int> queuedTasks{0};
+    std::atomic<bool> stopping{false};
+
+    QMutex sleepMutex;
+    QWaitCondition wakeUp;
+};
+
+#endif // CODECEXECUTOR_H
@@ -0,0 +1,89 @@
+// ComplexityController.cpp
+
+#include "ComplexityController.h"
+#include <QMutexLocker>
+#include <algorithm>
+
+namespace {
+
+constexpr double kSmoothing = 0.1;         // EWMA weight of the newest frame, about 10 frames of memory
+constexpr double kDropThreshold = 0.5;     // Half the frame budget spent: step down
+constexpr double kRaiseThreshold = 0.2;    // Under a fifth of the budget: candidate for stepping up
+constexpr int kDropHoldFrames = 5;         // 100 ms for a step down to take effect before the next
+constexpr int kRaiseHoldFrames = 100;      // 2 s of steady headroom before stepping up
+
+double toSeconds(ComplexityController::Clock::duration duration)
+{
+    return std::chrono::duration<double>(duration).count();
+}
+
+} // namespace
+
+// Constructor
+ComplexityController::ComplexityController(Clock::duration frameDuration, int initialComplexity)
+    : frameSeconds(toSeconds(frameDuration)),
+      initialComplexity(std::clamp(initialComplexity, kMinComplexity, kMaxComplexity))
+{
+    reset();
+}
+
+void ComplexityController::reset()
+{
+    QMutexLocker locker(&mutex);
+    stats = EncoderStats();
+    stats.complexity = initialComplexity;
+    framesSinceChange = 0;
+    headroomFrames = 0;
+}
+
+int ComplexityController::update(Clock::duration encodeTime, Clock::duration totalTime)
+{
+    QMutexLocker locker(&mutex);
+
+    const double usage = toSeconds(totalTime) / frameSeconds;
+    const double encodeMs = toSeconds(encodeTime) * 1000.0;
+    const bool late = usage >= 1.0;
+
+    if (stats.framesEncoded == 0) {
+        stats.encodeMs = encodeMs;
+        stats.budgetUsage = usage;
+    } else {
+        stats.encodeMs += kSmoothing * (encodeMs - stats.encodeMs);
+        stats.budgetUsage += kSmoothing * (usage - stats.budgetUsage);
+    }
+    ++stats.framesEncoded;
+    if (late)
+        ++stats.lateFrames;
+    ++framesSinceChange;
+    headroomFrames = stats.budgetUsage < kRaiseThreshold ? headroomFrames + 1 : 0;
+
+    // A late frame counts at once; the average alone would react a few frames too slowly
+    if ((late || stats.budgetUsage > kDropThreshold) && framesSinceChange >= kDropHoldFrames
+        && stats.complexity > kMinComplexity) {
+        --stats.complexity;
+        ++stats.complexityDrops;
+        framesSinceChange = 0;
+        headroomFrames = 0;
+    } else if (headroomFrames >= kRaiseHoldFrames && framesSinceChange >= kRaiseHoldFrames
+               && stats.complexity < initialComplexity) {
+        // Only climb back to where the call started; the initial value is the quality ceiling
+        ++stats.complexity;
+        ++stats.complexityRaises;
+        framesSinceChange = 0;
+        headroomFrames = 0;
+    }
+
+    return stats.complexity;
+}
+
+int ComplexityController::complexity() const
+{
+    QMutexLocker locker(&mutex);
+    return stats.complexity;
+}
+
+EncoderStats ComplexityController::snapshot() const
+{
+    QMutexLocker locker(&mutex);
+    return stats;
+}
@@ -0,0 +1,56 @@
+// ComplexityController.h
+
+#ifndef COMPLEXITYCONTROLLER_H
+#define COMPLEXITYCONTROLLER_H
+
+#include <QMutex>
+#include <chrono>
+#include <cstdint>
+
+// Encoder health of one call, for logs and statistics
+struct EncoderStats
+{
+    int complexity = 0;          // Opus complexity in use, 0..10
+    double encodeMs = 0.0;       // Smoothed opus_encode time per frame
+    double budgetUsage = 0.0;    // Smoothed (queueing + processing + encode) time as a fraction of the frame duration
+    uint64_t framesEncoded = 0;
+    uint64_t lateFrames = 0;     // Frames finished after their real-time deadline
+    int complexityDrops = 0;
+    int complexityRaises = 0;
+};
+
+// Picks the Opus encoder complexity for one call from measured per-frame timings.
+// When a frame's time from capture to encoded packet eats too much of its real-time budget,
+// complexity goes down one step; after a sustained stretch of headroom it goes back up,
+// but never above the initial value.
+// A hold period after each change keeps it from oscillating. Safe to snapshot from any thread.
+class ComplexityController
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int kMinComplexity = 2;  // Below this speech quality drops sharply
+    static constexpr int kMaxComplexity = 10;
+
+    explicit ComplexityController(Clock::duration frameDuration = std::chrono::milliseconds(20),
+                                  int initialComplexity = 9); // libopus' own default
+
+    // Start of a new call: statistics are cleared and complexity returns to its initial value
+    void reset();
+
+    // Feeds one encoded frame; returns the complexity the next frame should use
+    int update(Clock::duration encodeTime, Clock::duration totalTime);
+
+    int complexity() const;
+    EncoderStats snapshot() const;
+
+private:
+    mutable QMutex mutex;
+    double frameSeconds;
+    int initialComplexity;
+    EncoderStats stats;
+    int framesSinceChange = 0;
+    int headroomFrames = 0;  // Consecutive frames below the raise threshold
+};
+
+#endif // COMPLEXITYCONTROLLER_H
@@ -0,0 +1,127 @@
+// DspChain.h
+
+#ifndef DSPCHAIN_H
+#define DSPCHAIN_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// One processing step on mono float audio in [-1, 1]. Stages work in place and
+// must not allocate or lock in process(); any state they need is set up in the constructor.
+class DspStage
+{
+public:
+    virtual ~DspStage() = default;
+
+    // count never exceeds the chain's frame size
+    virtual void process(float* samples, int count) = 0;
+};
+
+// Fixed gain, e.g. to trim a hot microphone
+class Gain : public DspStage
+{
+public:
+    explicit Gain(float gainDb);
+    void process(float* samples, int count) override;
+
+private:
+    float gain;
+};
+
+// Second-order Butterworth high-pass that removes rumble and DC below the cutoff
+class HighPassFilter : public DspStage
+{
+public:
+    HighPassFilter(float cutoffHz, int sampleRate);
+    void process(float* samples, int count) override;
+
+private:
+    float b0, b1, b2, a1, a2; // Normalized biquad coefficients
+    float z1 = 0.0f, z2 = 0.0f; // Transposed direct form II state
+};
+
+// Automatic gain control: steers the frame RMS toward a target level.
+// Gain drops quickly on loud input and rises slowly; frames below the noise floor leave it untouched.
+class AutomaticGainControl : public DspStage
+{
+public:
+    AutomaticGainControl(int sampleRate, float targetDb = -18.0f, float maxGainDb = 20.0f);
+    void process(float* samples, int count) override;
+
+private:
+    int sampleRate;
+    float target;
+    float maxGain;
+    float minGain;
+    float noiseFloor;
+    float gain = 1.0f;
+};
+
+// Peak limiter without lookahead: gain falls at once when a frame would exceed the
+// threshold, recovers over the release time, and a final clip catches the first samples.
+class Limiter : public DspStage
+{
+public:
+    Limiter(int sampleRate, float thresholdDb = -1.0f, float releaseMs = 50.0f);
+    void process(float* samples, int count) override;
+
+private:
+    int sampleRate;
+    float threshold;
+    float releaseSeconds;
+    float gain = 1.0f;
+};
+
+// Measures peak and RMS level of each frame without changing it.
+// Levels can be read from any thread.
+class LevelMeter : public DspStage
+{
+public:
+    void process(float* samples, int count) override;
+
+    float peakDb() const;
+    float rmsDb() const;
+
+private:
+    std::atomic<float> peak{0.0f};
+    std::atomic<float> rms{0.0f};
+};
+
+// Ordered list of stages run on every block of audio between a device and the codec:
+// captured frames before encoding, or the mix of decoded streams before playback.
+// The float working buffer is allocated in the constructor, so process() never allocates.
+// Stages are added during setup; after that the chain belongs to the thread that processes frames.
+class DspChain
+{
+public:
+    explicit DspChain(int frameSize = 960);
+
+    // Appends a stage and returns it, so callers can keep a pointer to e.g. a meter
+    template <typename Stage, typename... Args>
+    Stage* add(Args&&... args)
+    {
+        auto stage = std::make_unique<Stage>(std::forward<Args>(args)...);
+        Stage* raw = stage.get();
+        stages.push_back(std::move(stage));
+        return raw;
+    }
+
+    bool isEmpty() const;
+
+    // Runs every stage over Int16 samples in place, frameSize samples at a time
+    void process(int16_t* pcm, int count);
+
+    // Same on float samples, for callers that already hold float audio. Values may exceed
+    // [-1, 1], e.g. a mix of several talkers; the stages see them before anything clips.
+    void process(float* samples, int count);
+
+private:
+    int frameSize;
+    std::vector<float> working; // One frame as float
+    std::vector<std::unique_ptr<DspStage>> stages;
+};
+
+#endif // DSPCHAIN_H
@@ -0,0 +1,77 @@
+// FramePool.cpp
+
+#include "FramePool.h"
+#include <QMutexLocker>
+#include <utility>
+
+FrameHandle::FrameHandle(std::shared_ptr<FramePool> pool, AudioFrame* frame)
+    : pool(std::move(pool)), frame(frame)
+{
+}
+
+FrameHandle::FrameHandle(FrameHandle&& other) noexcept
+    : pool(std::move(other.pool)), frame(std::exchange(other.frame, nullptr))
+{
+}
+
+FrameHandle& FrameHandle::operator=(FrameHandle&& other) noexcept
+{
+    if (this != &other) {
+        reset();
+        pool = std::move(other.pool);
+        frame = std::exchange(other.frame, nullptr);
+    }
+    return *this;
+}
+
+FrameHandle::~FrameHandle()
+{
+    reset();
+}
+
+// Hand the frame back to its pool early
+void FrameHandle::reset()
+{
+    if (frame) {
+        pool->release(frame);
+        frame = nullptr;
+    }
+    pool.reset();
+}
+
+std::shared_ptr<FramePool> FramePool::create(int capacity)
+{
+    return std::shared_ptr<FramePool>(new FramePool(capacity));
+}
+
+// Constructor
+FramePool::FramePool(int capacity)
+    : storage(new AudioFrame[capacity]), frameCount(capacity)
+{
+    freeFrames.reserve(capacity);
+    for (int i = 0; i < capacity; ++i)
+        freeFrames.push_back(&storage[i]);
+}
+
+FrameHandle FramePool::acquire()
+{
+    QMutexLocker locker(&mutex);
+    if (freeFrames.empty())
+        return FrameHandle();
+
+    AudioFrame* frame = freeFrames.back();
+    freeFrames.pop_back();
+    frame->size = 0;
+    return FrameHandle(shared_from_this(), frame);
+}
+
+int FramePool::capacity() const
+{
+    return frameCount;
+}
+
+void FramePool::release(AudioFrame* frame)
+{
+    QMutexLocker locker(&mutex);
+    freeFrames.push_back(frame); // Never grows past the reserved capacity
+}
@@ -0,0 +1,74 @@
+// FramePool.h
+
+#ifndef FRAMEPOOL_H
+#define FRAMEPOOL_H
+
+#include <QMutex>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+// Large enough for a 20 ms mono PCM frame (1920 bytes) and for any Opus packet,
+// which libopus recommends capping at 4000 bytes
+constexpr int kMaxFrameBytes = 4000;
+
+// One fixed-size audio buffer owned by a FramePool
+struct AudioFrame {
+    int size = 0; // Bytes of data in use
+    std::chrono::steady_clock::time_point timestamp; // Capture time of the last sample, for deadlines and latency accounting
+    std::chrono::steady_clock::time_point readyTime; // When the frame was complete and handed to the codec
+    alignas(16) unsigned char data[kMaxFrameBytes];
+};
+
+class FramePool;
+
+// Move-only reference to a pooled frame; the frame goes back to its pool when the handle dies
+class FrameHandle
+{
+public:
+    FrameHandle() = default;
+    FrameHandle(FrameHandle&& other) noexcept;
+    FrameHandle& operator=(FrameHandle&& other) noexcept;
+    FrameHandle(const FrameHandle&) = delete;
+    FrameHandle& operator=(const FrameHandle&) = delete;
+    ~FrameHandle();
+
+    AudioFrame* operator->() const { return frame; }
+    AudioFrame& operator*() const { return *frame; }
+    explicit operator bool() const { return frame != nullptr; }
+
+    void reset();
+
+private:
+    friend class FramePool;
+    FrameHandle(std::shared_ptr<FramePool> pool, AudioFrame* frame);
+
+    std::shared_ptr<FramePool> pool;
+    AudioFrame* frame = nullptr;
+};
+
+// Preallocated set of frames so the steady-state media path never touches the heap.
+// All memory is allocated in create(); acquire() and release are lock-protected pointer moves.
+class FramePool : public std::enable_shared_from_this<FramePool>
+{
+public:
+    static std::shared_ptr<FramePool> create(int capacity);
+
+    // Returns an empty handle when every frame is in flight
+    FrameHandle acquire();
+
+    int capacity() const;
+
+private:
+    friend class FrameHandle;
+    explicit FramePool(int capacity);
+
+    void release(AudioFrame* frame);
+
+    std::unique_ptr<AudioFrame[]> storage;
+    std::vector<AudioFrame*> freeFrames;
+    int frameCount;
+    QMutex mutex;
+};
+
+#endif // FRAMEPOOL_H
@@ -0,0 +1,68 @@
+// PcmRingBuffer.h
+
+#ifndef PCMRINGBUFFER_H
+#define PCMRINGBUFFER_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Single-producer/single-consumer queue of 16-bit samples.
+// Storage is allocated once in the constructor; write() and read() never allocate or lock.
+class PcmRingBuffer
+{
+public:
+    explicit PcmRingBuffer(int minimumCapacity)
+    {
+        int capacity = 1;
+        while (capacity < minimumCapacity)
+            capacity <<= 1;
+        samples.resize(capacity);
+        mask = capacity - 1;
+    }
+
+    // Producer side; returns how many samples fitted
+    int write(const int16_t* data, int count)
+    {
+        const uint32_t head = writeIndex.load(std::memory_order_relaxed);
+        const uint32_t tail = readIndex.load(std::memory_order_acquire);
+        count = std::min<int>(count, static_cast<int>(samples.size() - (head - tail)));
+
+        const int first = std::min<int>(count, static_cast<int>(samples.size() - (head & mask)));
+        std::memcpy(&samples[head & mask], data, first * sizeof(int16_t));
+        std::memcpy(&samples[0], data + first, (count - first) * sizeof(int16_t));
+
+        writeIndex.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer side; returns how many samples were available
+    int read(int16_t* data, int count)
+    {
+        const uint32_t tail = readIndex.load(std::memory_order_relaxed);
+        const uint32_t head = writeIndex.load(std::memory_order_acquire);
+        count = std::min<int>(count, static_cast<int>(head - tail));
+
+        const int first = std::min<int>(count, static_cast<int>(samples.size() - (tail & mask)));
+        std::memcpy(data, &samples[tail & mask], first * sizeof(int16_t));
+        std::memcpy(data + first, &samples[0], (count - first) * sizeof(int16_t));
+
+        readIndex.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    int available() const
+    {
+        return static_cast<int>(writeIndex.load(std::memory_order_acquire) - readIndex.load(std::memory_order_acquire));
+    }
+
+private:
+    std::vector<int16_t> samples;
+    uint32_t mask = 0;
+    std::atomic<uint32_t> writeIndex{0};
+    std::atomic<uint32_t> readIndex{0};
+};
+
+#endif // PCMRINGBUFFER_H
@@ -0,0 +1,115 @@
+// PolyphaseResampler.cpp
+
+#include "PolyphaseResampler.h"
+#include "SampleKernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+constexpr double kKaiserBeta = 8.0; // About 80 dB stopband attenuation
+
+// Zeroth-order modified Bessel function, for the Kaiser window
+double besselI0(double x)
+{
+    double sum = 1.0;
+    double term = 1.0;
+    for (int k = 1; k < 32; ++k) {
+        term *= (x / (2.0 * k)) * (x / (2.0 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+} // namespace
+
+// Constructor
+PolyphaseResampler::PolyphaseResampler(int inputRate, int outputRate, int maxInputFrames)
+    : inputRate(inputRate), maxInput(maxInputFrames)
+{
+    const int divisor = std::gcd(inputRate, outputRate);
+    upFactor = outputRate / divisor;
+    downFactor = inputRate / divisor;
+
+    history.assign(kTapsPerPhase - 1 + maxInputFrames, 0.0f);
+    reset();
+
+    if (isPassthrough())
+        return;
+
+    // Prototype low-pass at the upsampled rate, cut off just below the lower Nyquist frequency
+    const int length = kTapsPerPhase * upFactor;
+    const double cutoff = 0.5 * 0.92 / std::max(upFactor, downFactor); // Cycles per upsampled sample
+    const double center = (length - 1) / 2.0;
+    std::vector<double> prototype(length);
+    for (int n = 0; n < length; ++n) {
+        const double t = n - center;
+        const double sinc = (t == 0.0) ? 1.0 : std::sin(2.0 * kPi * cutoff * t) / (2.0 * kPi * cutoff * t);
+        const double ratio = t / (length / 2.0);
+        const double window = besselI0(kKaiserBeta * std::sqrt(std::max(0.0, 1.0 - ratio * ratio))) / besselI0(kKaiserBeta);
+        // Gain of L makes up for the zeros inserted by upsampling
+        prototype[n] = upFactor * 2.0 * cutoff * sinc * window;
+    }
+
+    // Phase p uses prototype taps p, p + L, p + 2L, ... applied to x[i], x[i - 1], ...
+    coefficients.resize(length);
+    for (int p = 0; p < upFactor; ++p) {
+        for (int k = 0; k < kTapsPerPhase; ++k)
+            coefficients[p * kTapsPerPhase + (kTapsPerPhase - 1 - k)] = static_cast<float>(prototype[k * upFactor + p]);
+    }
+}
+
+bool PolyphaseResampler::isPassthrough() const
+{
+    return upFactor == downFactor;
+}
+
+int PolyphaseResampler::maxOutputFrames(int inputFrames) const
+{
+    return static_cast<int>((static_cast<long long>(inputFrames) * upFactor) / downFactor) + 2;
+}
+
+int PolyphaseResampler::process(const float* in, int inputFrames, float* out)
+{
+    inputFrames = std::min(inputFrames, maxInput);
+    if (isPassthrough()) {
+        std::memcpy(out, in, inputFrames * sizeof(float));
+        return inputFrames;
+    }
+
+    const int keep = kTapsPerPhase - 1;
+    std::memcpy(history.data() + keep, in, inputFrames * sizeof(float));
+    const int available = keep + inputFrames;
+
+    int produced = 0;
+    while (position < available) {
+        const float* window = history.data() + position - keep;
+        out[produced++] = SampleKernels::dotProduct(coefficients.data() + phase * kTapsPerPhase, window, kTapsPerPhase);
+
+        // Advance by M upsampled steps
+        phase += downFactor;
+        position += phase / upFactor;
+        phase %= upFactor;
+    }
+
+    // Keep the tail as history for the next block
+    std::memmove(history.data(), history.data() + inputFrames, keep * sizeof(float));
+    position -= inputFrames;
+    return produced;
+}
+
+double PolyphaseResampler::latency() const
+{
+    // Centre of the prototype filter, converted back to input samples
+    return isPassthrough() ? 0.0 : (kTapsPerPhase * upFactor - 1) / (2.0 * upFactor) / inputRate;
+}
+
+void PolyphaseResampler::reset()
+{
+    std::fill(history.begin(), history.end(), 0.0f);
+    position = kTapsPerPhase - 1;
+    phase = 0;
+}
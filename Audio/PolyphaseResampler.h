@@ -0,0 +1,44 @@
+// PolyphaseResampler.h
+
+#ifndef POLYPHASERESAMPLER_H
+#define POLYPHASERESAMPLER_H
+
+#include <vector>
+
+// Streaming mono sample-rate converter for a rational ratio L/M (e.g. 44.1 -> 48 kHz is 160/147).
+// A Kaiser-windowed sinc prototype is split into L phases of kTapsPerPhase taps each,
+// so every output sample costs one kTapsPerPhase-long dot product.
+// The group delay is fixed at just under kTapsPerPhase / 2 input samples.
+class PolyphaseResampler
+{
+public:
+    static constexpr int kTapsPerPhase = 32;
+
+    PolyphaseResampler(int inputRate, int outputRate, int maxInputFrames);
+
+    bool isPassthrough() const;
+
+    // Upper bound of output frames for an input block of the given size
+    int maxOutputFrames(int inputFrames) const;
+
+    // Consumes every input frame (at most maxInputFrames) and returns the number of output frames
+    int process(const float* in, int inputFrames, float* out);
+
+    // Added delay in seconds
+    double latency() const;
+
+    void reset();
+
+private:
+    int inputRate;
+    int upFactor;   // L
+    int downFactor; // M
+    int maxInput;
+
+    std::vector<float> coefficients; // upFactor phases, each reversed so the dot product runs forwards
+    std::vector<float> history;      // kTapsPerPhase - 1 past samples followed by the current block
+    int position = 0;                // Index in history of the newest sample used by the next output
+    int phase = 0;                   // Sub-sample position of the next output, in 1/L steps
+};
+
+#endif // POLYPHASERESAMPLER_H
@@ -0,0 +1,331 @@
+// SampleKernels.cpp
+
+#include "SampleKernels.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SAMPLEKERNELS_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// AVX2 bodies are compiled per function, so the rest of the build keeps its baseline target
+#if defined(SAMPLEKERNELS_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#define SAMPLEKERNELS_AVX2 1
+#define AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#endif
+
+namespace {
+
+#ifdef SAMPLEKERNELS_AVX2
+
+// Resolved once at load time; every kernel checks this flag before taking its AVX2 path
+const bool useAvx2 = __builtin_cpu_supports("avx2");
+
+// Each helper handles whole 8- or 16-sample blocks and returns how many samples it consumed;
+// the caller finishes the tail with its SSE2 and scalar loops.
+
+AVX2_TARGET int int16ToFloatAvx2(const int16_t* in, float* out, int count)
+{
+    const __m256 vscale = _mm256_set1_ps(1.0f / 32768.0f);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        __m256 values = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(samples));
+        _mm256_storeu_ps(out + i, _mm256_mul_ps(values, vscale));
+    }
+    return i;
+}
+
+AVX2_TARGET int floatToInt16Avx2(const float* in, int16_t* out, int count)
+{
+    const __m256 vscale = _mm256_set1_ps(32768.0f);
+    const __m256 vmin = _mm256_set1_ps(-1.0f);
+    const __m256 vmax = _mm256_set1_ps(1.0f);
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256 a = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i), vmin), vmax);
+        __m256 b = _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(in + i + 8), vmin), vmax);
+        __m256i low = _mm256_cvtps_epi32(_mm256_mul_ps(a, vscale));
+        __m256i high = _mm256_cvtps_epi32(_mm256_mul_ps(b, vscale));
+        // packs works per 128-bit lane; the permute puts the four quarters back in order
+        __m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(low, high), _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), packed);
+    }
+    return i;
+}
+
+AVX2_TARGET int applyGainAvx2(float* samples, int count, float gain)
+{
+    const __m256 vgain = _mm256_set1_ps(gain);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(samples + i, _mm256_mul_ps(_mm256_loadu_ps(samples + i), vgain));
+    return i;
+}
+
+AVX2_TARGET int applyGainRampAvx2(float* samples, int count, float startGain, float step)
+{
+    __m256 vgain = _mm256_add_ps(_mm256_set1_ps(startGain),
+                                 _mm256_mul_ps(_mm256_set1_ps(step), _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7)));
+    const __m256 vstep = _mm256_set1_ps(step * 8.0f);
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm256_storeu_ps(samples + i, _mm256_mul_ps(_mm256_loadu_ps(samples + i), vgain));
+        vgain = _mm256_add_ps(vgain, vstep);
+    }
+    return i;
+}
+
+AVX2_TARGET int clipAvx2(float* samples, int count, float limit)
+{
+    const __m256 vmax = _mm256_set1_ps(limit);
+    const __m256 vmin = _mm256_set1_ps(-limit);
+    int i = 0;
+    for (; i + 8 <= count; i += 8)
+        _mm256_storeu_ps(samples + i, _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(samples + i), vmin), vmax));
+    return i;
+}
+
+AVX2_TARGET int measureLevelAvx2(const float* samples, int count, float* peak, float* sumOfSquares)
+{
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    __m256 vpeak = _mm256_setzero_ps();
+    __m256 venergy = _mm256_setzero_ps();
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256 values = _mm256_loadu_ps(samples + i);
+        vpeak = _mm256_max_ps(vpeak, _mm256_andnot_ps(signMask, values));
+        venergy = _mm256_add_ps(venergy, _mm256_mul_ps(values, values));
+    }
+    alignas(32) float peaks[8];
+    alignas(32) float energies[8];
+    _mm256_store_ps(peaks, vpeak);
+    _mm256_store_ps(energies, venergy);
+    for (int lane = 0; lane < 8; ++lane) {
+        *peak = std::max(*peak, peaks[lane]);
+        *sumOfSquares += energies[lane];
+    }
+    return i;
+}
+
+#endif // SAMPLEKERNELS_AVX2
+
+} // namespace
+
+namespace SampleKernels {
+
+void int16ToFloat(const int16_t* in, float* out, int count)
+{
+    const float scale = 1.0f / 32768.0f;
+    int i = 0;
+#ifdef SAMPLEKERNELS_AVX2
+    if (useAvx2)
+        i = int16ToFloatAvx2(in, out, count);
+#endif
+#ifdef SAMPLEKERNELS_SSE2
+    const __m128 vscale = _mm_set1_ps(scale);
+    for (; i + 8 <= count; i += 8) {
+        __m128i samples = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+        // Sign-extend by placing each sample in the upper half and shifting back down
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16);
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(low), vscale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), vscale));
+    }
+#endif
+    for (; i < count; ++i)
+        out[i] = in[i] * scale;
+}
+
+void floatToInt16(const float* in, int16_t* out, int count)
+{
+    int i = 0;
+#ifdef SAMPLEKERNELS_AVX2
+    if (useAvx2)
+        i = floatToInt16Avx2(in, out, count);
+#endif
+#ifdef SAMPLEKERNELS_SSE2
+    const __m128 vscale = _mm_set1_ps(32768.0f);
+    const __m128 vmin = _mm_set1_ps(-1.0f);
+    const __m128 vmax = _mm_set1_ps(1.0f);
+    for (; i + 8 <= count; i += 8) {
+        // Clamp first so cvtps never overflows; it rounds to nearest and packs saturates 32768
+        __m128 a = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i), vmin), vmax);
+        __m128 b = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(in + i + 4), vmin), vmax);
+        __m128i low = _mm_cvtps_epi32(_mm_mul_ps(a, vscale));
+        __m128i high = _mm_cvtps_epi32(_mm_mul_ps(b, vscale));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), _mm_packs_epi32(low, high));
+    }
+#endif
+    for (; i < count; ++i) {
+        float value = std::nearbyint(std::clamp(in[i], -1.0f, 1.0f) * 32768.0f);
+        out[i] = static_cast<int16_t>(std::min(value, 32767.0f));
+    }
+}
+
+void downmixToMono(const float* in, float* out, int frames, int channels)
+{
+    int i = 0;
+#ifdef SAMPLEKERNELS_SSE2
+    if (channels == 2) {
+        const __m128 half = _mm_set1_ps(0.5f);
+        for (; i + 4 <= frames; i += 4) {
+            __m128 a = _mm_loadu_ps(in + 2 * i);     // L0 R0 L1 R1
+            __m128 b = _mm_loadu_ps(in + 2 * i + 4); // L2 R2 L3 R3
+            __m128 left = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            __m128 right = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+            _mm_storeu_ps(out + i, _mm_mul_ps(_mm_add_ps(left, right), half));
+        }
+    }
+#endif
+    const float scale = 1.0f / channels;
+    for (; i < frames; ++i) {
+        float sum = 0.0f;
+        for (int c = 0; c < channels; ++c)
+            sum += in[i * channels + c];
+        out[i] = sum * scale;
+    }
+}
+
+void upmixFromMono(const float* in, float* out, int frames, int channels)
+{
+    int i = 0;
+#ifdef SAMPLEKERNELS_SSE2
+    if (channels == 2) {
+        for (; i + 4 <= frames; i += 4) {
+            __m128 mono = _mm_loadu_ps(in + i);
+            _mm_storeu_ps(out + 2 * i, _mm_unpacklo_ps(mono, mono));
+            _mm_storeu_ps(out + 2 * i + 4, _mm_unpackhi_ps(mono, mono));
+        }
+    }
+#endif
+    for (; i < frames; ++i) {
+        for (int c = 0; c < channels; ++c)
+            out[i * channels + c] = in[i];
+    }
+}
+
+float dotProduct(const float* a, const float* b, int count)
+{
+    int i = 0;
+    float sum = 0.0f;
+#ifdef SAMPLEKERNELS_SSE2
+    __m128 acc0 = _mm_setzero_ps();
+    __m128 acc1 = _mm_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+        acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(a + i + 4), _mm_loadu_ps(b + i + 4)));
+    }
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, _mm_add_ps(acc0, acc1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < count; ++i)
+        sum += a[i] * b[i];
+    return sum;
+}
+
+void applyGain(float* samples, int count, float gain)
+{
+    int i = 0;
+#ifdef SAMPLEKERNELS_AVX2
+    if (useAvx2)
+        i = applyGainAvx2(samples, count, gain);
+#endif
+#ifdef SAMPLEKERNELS_SSE2
+    const __m128 vgain = _mm_set1_ps(gain);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), vgain));
+#endif
+    for (; i < count; ++i)
+        samples[i] *= gain;
+}
+
+void applyGainRamp(float* samples, int count, float startGain, float endGain)
+{
+    if (count <= 1 || startGain == endGain) {
+        applyGain(samples, count, endGain);
+        return;
+    }
+
+    const float step = (endGain - startGain) / (count - 1);
+    int i = 0;
+#ifdef SAMPLEKERNELS_AVX2
+    if (useAvx2)
+        i = applyGainRampAvx2(samples, count, startGain, step);
+#endif
+#ifdef SAMPLEKERNELS_SSE2
+    __m128 vgain = _mm_add_ps(_mm_set1_ps(startGain + step * i),
+                              _mm_mul_ps(_mm_set1_ps(step), _mm_setr_ps(0, 1, 2, 3)));
+    const __m128 vstep = _mm_set1_ps(step * 4.0f);
+    for (; i + 4 <= count; i += 4) {
+        _mm_storeu_ps(samples + i, _mm_mul_ps(_mm_loadu_ps(samples + i), vgain));
+        vgain = _mm_add_ps(vgain, vstep);
+    }
+#endif
+    for (; i < count; ++i)
+        samples[i] *= startGain + step * i;
+}
+
+void clip(float* samples, int count, float limit)
+{
+    int i = 0;
+#ifdef SAMPLEKERNELS_AVX2
+    if (useAvx2)
+        i = clipAvx2(samples, count, limit);
+#endif
+#ifdef SAMPLEKERNELS_SSE2
+    const __m128 vmax = _mm_set1_ps(limit);
+    const __m128 vmin = _mm_set1_ps(-limit);
+    for (; i + 4 <= count; i += 4)
+        _mm_storeu_ps(samples + i, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(samples + i), vmin), vmax));
+#endif
+    for (; i < count; ++i)
+        samples[i] = std::clamp(samples[i], -limit, limit);
+}
+
+void measureLevel(const float* samples, int count, float* peak, float* sumOfSquares)
+{
+    *peak = 0.0f;
+    *sumOfSquares = 0.0f;
+    int i = 0;
+#ifdef SAMPLEKERNELS_AVX2
+    if (useAvx2)
+        i = measureLevelAvx2(samples, count, peak, sumOfSquares);
+#endif
+#ifdef SAMPLEKERNELS_SSE2
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    __m128 vpeak = _mm_setzero_ps();
+    __m128 venergy = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        __m128 values = _mm_loadu_ps(samples + i);
+        vpeak = _mm_max_ps(vpeak, _mm_andnot_ps(signMask, values));
+        venergy = _mm_add_ps(venergy, _mm_mul_ps(values, values));
+    }
+    alignas(16) float peaks[4];
+    alignas(16) float energies[4];
+    _mm_store_ps(peaks, vpeak);
+    _mm_store_ps(energies, venergy);
+    for (int lane = 0; lane < 4; ++lane) {
+        *peak = std::max(*peak, peaks[lane]);
+        *sumOfSquares += energies[lane];
+    }
+#endif
+    for (; i < count; ++i) {
+        *peak = std::max(*peak, std::fabs(samples[i]));
+        *sumOfSquares += samples[i] * samples[i];
+    }
+}
+
+bool hasAvx2()
+{
+#ifdef SAMPLEKERNELS_AVX2
+    return useAvx2;
+#else
+    return false;
+#endif
+}
+
+} // namespace SampleKernels
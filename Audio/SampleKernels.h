@@ -0,0 +1,45 @@
+// SampleKernels.h
+
+#ifndef SAMPLEKERNELS_H
+#define SAMPLEKERNELS_H
+
+#include <cstdint>
+
+// Vectorized inner loops shared by the format converter, the resampler and the DSP chain.
+// SSE2 paths are used whenever the target guarantees SSE2 (every x86-64 build);
+// other targets fall back to plain loops with identical results.
+// With GCC or Clang on x86, AVX2 versions are also built and picked at runtime when the CPU has AVX2.
+namespace SampleKernels {
+
+// [-32768, 32767] -> [-1, 1)
+void int16ToFloat(const int16_t* in, float* out, int count);
+
+// [-1, 1] -> int16 with rounding and saturation
+void floatToInt16(const float* in, int16_t* out, int count);
+
+// Average interleaved channels into one mono channel
+void downmixToMono(const float* in, float* out, int frames, int channels);
+
+// Copy a mono channel into every channel of an interleaved buffer
+void upmixFromMono(const float* in, float* out, int frames, int channels);
+
+float dotProduct(const float* a, const float* b, int count);
+
+// samples[i] *= gain
+void applyGain(float* samples, int count, float gain);
+
+// Gain moves linearly from startGain and reaches endGain on the last sample, so changes do not click
+void applyGainRamp(float* samples, int count, float startGain, float endGain);
+
+// Clamp to [-limit, limit]
+void clip(float* samples, int count, float limit);
+
+// Largest absolute sample and sum of squares, in one pass
+void measureLevel(const float* samples, int count, float* peak, float* sumOfSquares);
+
+// True when the AVX2 paths are in use on this machine
+bool hasAvx2();
+
+} // namespace SampleKernels
+
+#endif // SAMPLEKERNELS_H
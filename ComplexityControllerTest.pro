@@ -0,0 +1,14 @@
+# Unit test of the Opus complexity controller; needs no audio or network libraries.
+# Run with "make check".
+QT        = core testlib
+CONFIG   += c++17 console testcase
+CONFIG   -= app_bundle
+TARGET    = tst_ComplexityController
+
+# Source and header files
+SOURCES += \
+    ComplexityController.cpp \
+    tst_ComplexityController.cpp
+
+HEADERS += \
+    ComplexityController.h
@@ -0,0 +1,81 @@
+#include "DaemonConfig.h"
+#include <QCommandLineParser>
+#include <QFileInfo>
+#include <QSettings>
+
+/**
+ * Fill the config from "--config <file>" first, then from the other options.
+ *
+ * Example file:
+ *   [call]
+ *   offerer=true
+ *   peers=alice, bob
+ *   audio=true
+ *   loopback=false
+ *   stdio=true
+ *   exitOnEof=false
+ */
+bool DaemonConfig::parse(const QStringList &arguments, QString *errorMessage)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Headless WebRTC audio endpoint. Signaling runs as JSON lines on stdin/stdout unless turned off.");
+    parser.addHelpOption();
+
+    const QCommandLineOption configOption("config", "Read settings from an INI file.", "file");
+    const QCommandLineOption offererOption("offerer", "Send offers to the configured peers.");
+    const QCommandLineOption peerOption("peer", "Peer to connect to; may be repeated.", "id");
+    const QCommandLineOption noAudioOption("no-audio", "Do not open audio devices.");
+    const QCommandLineOption loopbackOption("loopback", "Play the local capture back as well.");
+    const QCommandLineOption noStdioOption("no-stdio", "Do not read or write signaling on stdin/stdout.");
+    const QCommandLineOption exitOnEofOption("exit-on-eof", "Quit when stdin is closed.");
+    parser.addOptions({configOption, offererOption, peerOption, noAudioOption, loopbackOption,
+                       noStdioOption, exitOnEofOption});
+
+    if (!parser.parse(arguments)) {
+        *errorMessage = parser.errorText();
+        return false;
+    }
+    if (parser.isSet("help"))
+        parser.showHelp(); // Exits
+
+    if (parser.isSet(configOption)) {
+        const QString path = parser.value(configOption);
+        if (!QFileInfo::exists(path)) {
+            *errorMessage = QStringLiteral("Config file not found: %1").arg(path);
+            return false;
+        }
+
+        QSettings settings(path, QSettings::IniFormat);
+        settings.beginGroup("call");
+        offerer = settings.value("offerer", offerer).toBool();
+        peers = settings.value("peers", peers).toStringList();
+        audio = settings.value("audio", audio).toBool();
+        loopback = settings.value("loopback", loopback).toBool();
+        stdio = settings.value("stdio", stdio).toBool();
+        exitOnEof = settings.value("exitOnEof", exitOnEof).toBool();
+        settings.endGroup();
+    }
+
+    if (parser.isSet(offererOption))
+        offerer = true;
+    if (parser.isSet(peerOption))
+        peers = parser.values(peerOption);
+    if (parser.isSet(noAudioOption))
+        audio = false;
+    if (parser.isSet(loopbackOption))
+        loopback = true;
+    if (parser.isSet(noStdioOption))
+        stdio = false;
+    if (parser.isSet(exitOnEofOption))
+        exitOnEof = true;
+
+    for (QString &peer : peers)
+        peer = peer.trimmed();
+    peers.removeAll(QString());
+
+    if (offerer && peers.isEmpty()) {
+        *errorMessage = QStringLiteral("--offerer needs at least one --peer");
+        return false;
+    }
+    return true;
+}
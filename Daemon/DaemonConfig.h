@@ -0,0 +1,23 @@
+#ifndef DAEMONCONFIG_H
+#define DAEMONCONFIG_H
+
+#include <QString>
+#include <QStringList>
+
+/**
+ * Settings of the headless endpoint, read from an optional INI file and the command line.
+ * Command-line options win over the file.
+ */
+struct DaemonConfig
+{
+    bool        offerer = false;  // Create offers for the configured peers
+    QStringList peers;            // Peers to connect to at startup
+    bool        audio = true;     // Capture and play audio; off for pure relays and bots
+    bool        loopback = false; // Also play our own capture locally
+    bool        stdio = true;     // Signaling as JSON lines on stdin/stdout
+    bool        exitOnEof = false; // Quit when stdin closes, for supervisors that own the pipe
+
+    bool parse(const QStringList &arguments, QString *errorMessage);
+};
+
+#endif // DAEMONCONFIG_H
@@ -0,0 +1,116 @@
+#include <QCoreApplication>
+#include <QDebug>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QStringList>
+#include <memory>
+#include <utility>
+#include "AudioApp.h"
+#include "DaemonConfig.h"
+#include "StdioSignaling.h"
+#include "webRTC.h"
+
+int main(int argc, char *argv[]) {
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("PhoneCallDaemon");
+
+    DaemonConfig config;
+    QString error;
+    if (!config.parse(app.arguments(), &error)) {
+        qCritical().noquote() << error;
+        return 1;
+    }
+
+    // WebRTC endpoint, driven by JSON signaling on stdin/stdout
+    WebRTC webRTC;
+    webRTC.init(config.offerer);
+
+    // Without stdio signaling, or once stdin closes, the event loop keeps running
+    std::unique_ptr<StdioSignaling> signaling;
+    if (config.stdio) {
+        signaling = std::make_unique<StdioSignaling>(&webRTC);
+        QObject::connect(signaling.get(), &StdioSignaling::inputClosed, &app, [&]() {
+            if (config.exitOnEof)
+                app.quit();
+            else
+                qInfo() << "Signaling input closed";
+        });
+    }
+
+    std::unique_ptr<AudioApp> audioApp;
+
+    // Peers that are connected right now, read from codec workers for every frame,
+    // and the playback stream each one's audio is decoded on
+    QMutex peersMutex;
+    QStringList connectedPeers;
+    QHash<QString, int> peerStreams;
+    QObject::connect(&webRTC, &WebRTC::connected, &app, [&](const QString &peerId) {
+        QMutexLocker locker(&peersMutex);
+        if (!connectedPeers.contains(peerId))
+            connectedPeers.append(peerId);
+        if (audioApp && !peerStreams.contains(peerId)) {
+            const int stream = audioApp->openPlaybackStream();
+            if (stream < 0)
+                qWarning() << "No playback stream left, not playing audio from" << peerId;
+            else
+                peerStreams.insert(peerId, stream);
+        }
+    });
+    QObject::connect(&webRTC, &WebRTC::disconnected, &app, [&](const QString &peerId) {
+        QMutexLocker locker(&peersMutex);
+        connectedPeers.removeAll(peerId);
+        const int stream = peerStreams.value(peerId, -1);
+        peerStreams.remove(peerId);
+        if (audioApp && stream >= 0)
+            audioApp->closePlaybackStream(stream);
+    });
+
+    if (config.audio) {
+        audioApp = std::make_unique<AudioApp>();
+        audioApp->setLoopback(config.loopback);
+        audioApp->setEncodedFrameHandler([&](const AudioFrame &frame) {
+            QStringList peers;
+            {
+                QMutexLocker locker(&peersMutex);
+                peers = connectedPeers; // Shared copy, no allocation
+            }
+            // Iterate through a const view: a non-const begin() would detach and allocate on every frame
+            for (const QString &peerId : std::as_const(peers))
+                webRTC.sendFrame(peerId, frame);
+        });
+        webRTC.setEncoderStatsProvider([&]() { return audioApp->encoderStats(); });
+        webRTC.setIncomingFrameSink([&](const QString &peerId, FrameHandle frame) {
+            int stream;
+            {
+                QMutexLocker locker(&peersMutex);
+                stream = peerStreams.value(peerId, -1);
+            }
+            if (stream >= 0)
+                audioApp->playEncodedFrame(stream, std::move(frame));
+        });
+        audioApp->startRecording();
+    }
+
+    for (const QString &peerId : std::as_const(config.peers)) {
+        webRTC.addPeer(peerId);
+        if (config.offerer)
+            webRTC.generateOfferSDP(peerId);
+    }
+
+    if (signaling)
+        signaling->start();
+    const int result = app.exec();
+
+    // Stop media before the endpoint it sends to goes away
+    webRTC.setIncomingFrameSink(nullptr);
+    webRTC.setEncoderStatsProvider(nullptr);
+    if (audioApp) {
+        const EncoderStats stats = audioApp->encoderStats();
+        qInfo() << "Encoder: complexity" << stats.complexity << "frames" << stats.framesEncoded
+                << "late" << stats.lateFrames << "drops" << stats.complexityDrops
+                << "raises" << stats.complexityRaises << "encode ms" << stats.encodeMs;
+    }
+    audioApp.reset();
+    return result;
+}
@@ -0,0 +1,145 @@
+#include "StdioSignaling.h"
+#include "webRTC.h"
+#include <QDebug>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSocketNotifier>
+#include <utility>
+#ifdef Q_OS_WIN
+#include <QCoreApplication>
+#include <QMetaObject>
+#include <QPointer>
+#include <iostream>
+#include <string>
+#include <thread>
+#else
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+StdioSignaling::StdioSignaling(WebRTC *webRTC, QObject *parent)
+    : QObject{parent},
+    m_webRTC(webRTC),
+    m_out(stdout)
+{
+    connect(m_webRTC, &WebRTC::offerIsReady, this, [this](const QString &peerId, const QString &description) {
+        QJsonObject message = QJsonDocument::fromJson(description.toUtf8()).object();
+        message.insert("peer", peerId);
+        writeMessage(message);
+    });
+    connect(m_webRTC, &WebRTC::answerIsReady, this, [this](const QString &peerId, const QString &description) {
+        QJsonObject message = QJsonDocument::fromJson(description.toUtf8()).object();
+        message.insert("peer", peerId);
+        writeMessage(message);
+    });
+    connect(m_webRTC, &WebRTC::localCandidateGenerated, this,
+            [this](const QString &peerId, const QString &candidate, const QString &sdpMid) {
+        writeMessage({{"type", "candidate"}, {"peer", peerId}, {"candidate", candidate}, {"mid", sdpMid}});
+    });
+    connect(m_webRTC, &WebRTC::connected, this, [this](const QString &peerId) {
+        writeMessage({{"type", "connected"}, {"peer", peerId}});
+    });
+    connect(m_webRTC, &WebRTC::disconnected, this, [this](const QString &peerId) {
+        writeMessage({{"type", "disconnected"}, {"peer", peerId}});
+    });
+}
+
+/**
+ * Start reading stdin. On Unix a QSocketNotifier watches it from the event loop,
+ * so no thread ever blocks in a read.
+ *
+ * On Windows QSocketNotifier only watches sockets, and anonymous pipe handles
+ * cannot be waited on, so a plain thread blocks in getline instead. The thread
+ * is detached because that read cannot be interrupted; it posts to the
+ * application object and re-checks that we still exist there.
+ */
+void StdioSignaling::start()
+{
+#ifdef Q_OS_WIN
+    QPointer<StdioSignaling> self(this);
+    std::thread([self]() {
+        std::string line;
+        while (std::getline(std::cin, line)) {
+            const QString text = QString::fromStdString(line);
+            QMetaObject::invokeMethod(QCoreApplication::instance(), [self, text]() {
+                if (self)
+                    self->handleLine(text);
+            }, Qt::QueuedConnection);
+        }
+        QMetaObject::invokeMethod(QCoreApplication::instance(), [self]() {
+            if (self)
+                Q_EMIT self->inputClosed();
+        }, Qt::QueuedConnection);
+    }).detach();
+#else
+    m_input = new QSocketNotifier(STDIN_FILENO, QSocketNotifier::Read, this);
+    connect(m_input, &QSocketNotifier::activated, this, &StdioSignaling::readInput);
+#endif
+}
+
+/**
+ * Read what stdin has ready and apply every complete line. One read per
+ * wake-up never blocks, because the notifier only fires with data or EOF pending.
+ * Unused on Windows, where the reader thread delivers whole lines.
+ */
+void StdioSignaling::readInput()
+{
+#ifndef Q_OS_WIN
+    char buffer[4096];
+    const ssize_t count = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+    if (count < 0 && (errno == EINTR || errno == EAGAIN))
+        return;
+
+    if (count <= 0) {
+        // End of input: stop watching; what happens to the daemon is up to the owner of inputClosed()
+        m_input->setEnabled(false);
+        if (!m_pendingInput.isEmpty())
+            handleLine(QString::fromUtf8(std::exchange(m_pendingInput, QByteArray())));
+        Q_EMIT inputClosed();
+        return;
+    }
+
+    m_pendingInput.append(buffer, count);
+    qsizetype newline;
+    while ((newline = m_pendingInput.indexOf('\n')) >= 0) {
+        const QString line = QString::fromUtf8(m_pendingInput.constData(), newline);
+        m_pendingInput.remove(0, newline + 1);
+        handleLine(line);
+    }
+#endif
+}
+
+/**
+ * Apply one signaling message from stdin.
+ */
+void StdioSignaling::handleLine(const QString &line)
+{
+    if (line.trimmed().isEmpty())
+        return;
+
+    const QJsonObject message = QJsonDocument::fromJson(line.toUtf8()).object();
+    const QString type = message.value("type").toString();
+    const QString peerId = message.value("peer").toString();
+    if (peerId.isEmpty()) {
+        qWarning() << "Ignoring signaling message without a peer:" << line;
+        return;
+    }
+
+    if (type == "offer" || type == "answer") {
+        // An answering daemon accepts calls from peers it has not heard of yet
+        if (type == "offer" && !m_webRTC->hasPeer(peerId))
+            m_webRTC->addPeer(peerId);
+        m_webRTC->setRemoteDescription(peerId, message.value("sdp").toString());
+        if (type == "offer")
+            m_webRTC->generateAnswerSDP(peerId);
+    } else if (type == "candidate") {
+        m_webRTC->setRemoteCandidate(peerId, message.value("candidate").toString(), message.value("mid").toString());
+    } else {
+        qWarning() << "Unknown signaling message type:" << type;
+    }
+}
+
+void StdioSignaling::writeMessage(const QJsonObject &message)
+{
+    m_out << QJsonDocument(message).toJson(QJsonDocument::Compact) << Qt::endl;
+}
@@ -0,0 +1,51 @@
+#ifndef STDIOSIGNALING_H
+#define STDIOSIGNALING_H
+
+#include <QByteArray>
+#include <QJsonObject>
+#include <QObject>
+#include <QTextStream>
+
+class QSocketNotifier;
+class WebRTC;
+
+/**
+ * Signaling over stdin/stdout, one JSON object per line, so a supervisor
+ * process or a small bridge to the Socket.IO server can drive the daemon.
+ *
+ * Out: {"type":"offer"|"answer","peer":..,"sdp":..}
+ *      {"type":"candidate","peer":..,"candidate":..,"mid":..}
+ *      {"type":"connected"|"disconnected","peer":..}
+ * In:  {"type":"offer"|"answer","peer":..,"sdp":..}
+ *      {"type":"candidate","peer":..,"candidate":..,"mid":..}
+ *
+ * Input is read from the event loop when stdin becomes readable (on Windows,
+ * by a reader thread). When stdin closes, inputClosed() is emitted and reading
+ * stops; output keeps working.
+ */
+class StdioSignaling : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit StdioSignaling(WebRTC *webRTC, QObject *parent = nullptr);
+
+    void start();
+
+Q_SIGNALS:
+    void inputClosed();
+
+private Q_SLOTS:
+    void readInput();
+
+private:
+    void handleLine(const QString &line);
+    void writeMessage(const QJsonObject &message);
+
+    WebRTC          *m_webRTC;
+    QTextStream      m_out;
+    QSocketNotifier *m_input = nullptr;
+    QByteArray       m_pendingInput; // Bytes after the last complete line
+};
+
+#endif // STDIOSIGNALING_H
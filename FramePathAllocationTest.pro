@@ -0,0 +1,12 @@
+# Checks that the per-frame media path does not allocate once it is warmed up.
+# Run with "make check".
+QT        = core multimedia network websockets testlib
+CONFIG   += console testcase
+CONFIG   -= app_bundle
+TARGET    = tst_FramePathAllocation
+
+include(common.pri)
+
+# Source files
+SOURCES += \
+    tst_FramePathAllocation.cpp
@@ -0,0 +1,75 @@
+#include "CallStatsModel.h"
+
+CallStatsModel::CallStatsModel(QObject *parent)
+    : QAbstractListModel{parent}
+{
+}
+
+int CallStatsModel::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_stats.size();
+}
+
+QVariant CallStatsModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || index.row() >= m_stats.size())
+        return QVariant();
+
+    const CallStats &stats = m_stats.at(index.row());
+    switch (role) {
+    case PeerIdRole:          return stats.peerId;
+    case PacketsSentRole:     return stats.packetsSent;
+    case BytesSentRole:       return stats.bytesSent;
+    case PacketsReceivedRole: return stats.packetsReceived;
+    case BytesReceivedRole:   return stats.bytesReceived;
+    case PacketsLostRole:     return stats.packetsLost;
+    case FractionLostRole:    return stats.fractionLost;
+    case JitterRole:          return stats.jitterMs;
+    case RttRole:             return stats.rttMs;
+    case MosRole:             return stats.mos;
+    case EncoderComplexityRole: return stats.encoderComplexity;
+    case EncodeMsRole:        return stats.encodeMs;
+    case LateFramesRole:      return stats.lateFrames;
+    default:                  return QVariant();
+    }
+}
+
+QHash<int, QByteArray> CallStatsModel::roleNames() const
+{
+    return {
+        {PeerIdRole, "peerId"},
+        {PacketsSentRole, "packetsSent"},
+        {BytesSentRole, "bytesSent"},
+        {PacketsReceivedRole, "packetsReceived"},
+        {BytesReceivedRole, "bytesReceived"},
+        {PacketsLostRole, "packetsLost"},
+        {FractionLostRole, "fractionLost"},
+        {JitterRole, "jitterMs"},
+        {RttRole, "rttMs"},
+        {MosRole, "mos"},
+        {EncoderComplexityRole, "encoderComplexity"},
+        {EncodeMsRole, "encodeMs"},
+        {LateFramesRole, "lateFrames"}
+    };
+}
+
+/**
+ * Replace the rows, updating in place when the set of peers is unchanged.
+ */
+void CallStatsModel::setStats(const QVector<CallStats> &stats)
+{
+    bool samePeers = stats.size() == m_stats.size();
+    for (int i = 0; samePeers && i < stats.size(); ++i)
+        samePeers = stats.at(i).peerId == m_stats.at(i).peerId;
+
+    if (!samePeers) {
+        beginResetModel();
+        m_stats = stats;
+        endResetModel();
+        return;
+    }
+
+    m_stats = stats;
+    if (!m_stats.isEmpty())
+        Q_EMIT dataChanged(index(0), index(m_stats.size() - 1));
+}
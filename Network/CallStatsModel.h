@@ -0,0 +1,45 @@
+#ifndef CALLSTATSMODEL_H
+#define CALLSTATSMODEL_H
+
+#include <QAbstractListModel>
+#include <QVector>
+#include "RtcpSession.h"
+
+/**
+ * One row per peer with its latest RTCP-derived call quality and the local
+ * encoder's health, for QML views.
+ */
+class CallStatsModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    enum Roles {
+        PeerIdRole = Qt::UserRole + 1,
+        PacketsSentRole,
+        BytesSentRole,
+        PacketsReceivedRole,
+        BytesReceivedRole,
+        PacketsLostRole,
+        FractionLostRole,
+        JitterRole,
+        RttRole,
+        MosRole,
+        EncoderComplexityRole,
+        EncodeMsRole,
+        LateFramesRole
+    };
+
+    explicit CallStatsModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QHash<int, QByteArray> roleNames() const override;
+
+    void setStats(const QVector<CallStats> &stats);
+
+private:
+    QVector<CallStats> m_stats;
+};
+
+#endif // CALLSTATSMODEL_H
@@ -0,0 +1,111 @@
+#include "PeerSession.h"
+#include <QRandomGenerator>
+#include <QtEndian>
+#include <cstring>
+
+namespace {
+
+uint32_t randomSsrc()
+{
+    uint32_t ssrc = 0;
+    while (ssrc == 0)
+        ssrc = QRandomGenerator::system()->generate();
+    return ssrc;
+}
+
+} // namespace
+
+PeerSession::PeerSession(const QString &peerId, uint32_t ssrc, int payloadType)
+    : m_peerId(peerId),
+    m_ssrc(ssrc != 0 ? ssrc : randomSsrc()),
+    m_payloadType(payloadType),
+    // Random starting points make known-plaintext attacks on SRTP harder (RFC 3550 5.1)
+    m_initialSequence(static_cast<uint16_t>(QRandomGenerator::system()->generate())),
+    m_initialTimestamp(QRandomGenerator::system()->generate()),
+    m_rtcp(m_ssrc)
+{
+}
+
+const QString &PeerSession::peerId() const
+{
+    return m_peerId;
+}
+
+uint32_t PeerSession::ssrc() const
+{
+    return m_ssrc;
+}
+
+int PeerSession::payloadType() const
+{
+    return m_payloadType;
+}
+
+void PeerSession::setPayloadType(int payloadType)
+{
+    m_payloadType = payloadType;
+}
+
+std::shared_ptr<rtc::Track> PeerSession::track() const
+{
+    return m_track;
+}
+
+void PeerSession::setTrack(std::shared_ptr<rtc::Track> track)
+{
+    m_track = std::move(track);
+}
+
+/**
+ * Build the RTP packet in a per-thread scratch buffer and hand it to the track.
+ */
+bool PeerSession::sendFrame(const unsigned char *payload, int size)
+{
+    if (!m_track || !m_track->isOpen() || size > kMaxFrameBytes)
+        return false;
+
+    // Each sending thread reuses its own buffer, so concurrent calls never share or allocate one
+    alignas(8) thread_local unsigned char packet[kMaxRtpPacketSize];
+
+    const int packetSize = writeRtpPacket(payload, size, packet);
+    m_track->send(reinterpret_cast<const std::byte*>(packet), packetSize);
+    m_rtcp.onRtpSent(size, qFromBigEndian<quint32>(packet + 4));
+    return true;
+}
+
+/**
+ * Fill in the header from the stream's counters and copy the payload after it.
+ */
+int PeerSession::writeRtpPacket(const unsigned char *payload, int size, unsigned char *packet)
+{
+    if (size > kMaxFrameBytes)
+        return 0;
+
+    const uint32_t frame = m_framesSent.fetch_add(1, std::memory_order_relaxed);
+    const uint16_t sequenceNumber = static_cast<uint16_t>(m_initialSequence + frame);
+    const uint32_t timestamp = m_initialTimestamp + frame * kSamplesPerFrame;
+
+    // Version 2, no padding, extension or CSRCs; the marker bit flags the start of the stream
+    packet[0] = 0x80;
+    packet[1] = static_cast<unsigned char>((frame == 0 ? 0x80 : 0x00) | (m_payloadType & 0x7f));
+    qToBigEndian<quint16>(sequenceNumber, packet + 2);
+    qToBigEndian<quint32>(timestamp, packet + 4);
+    qToBigEndian<quint32>(m_ssrc, packet + 8);
+    std::memcpy(packet + kRtpHeaderSize, payload, size);
+    return kRtpHeaderSize + size;
+}
+
+int PeerSession::rtpPayloadOffset(const unsigned char *packet, int size)
+{
+    if (size < kRtpHeaderSize)
+        return -1;
+    int headerSize = kRtpHeaderSize + 4 * (packet[0] & 0x0f);
+    if ((packet[0] & 0x10) && size >= headerSize + 4)
+        headerSize += 4 + 4 * qFromBigEndian<quint16>(packet + headerSize + 2);
+    return headerSize <= size ? headerSize : -1;
+}
+
+RtcpSession &PeerSession::rtcp()
+{
+    return m_rtcp;
+}
@@ -0,0 +1,64 @@
+#ifndef PEERSESSION_H
+#define PEERSESSION_H
+
+#include <QString>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <rtc/rtc.hpp>
+#include "FramePool.h"
+#include "RtcpSession.h"
+
+/**
+ * Media state of one peer: its audio track, the outgoing RTP stream and RTCP bookkeeping.
+ *
+ * Every peer has its own random SSRC, sequence number and timestamp origin (RFC 3550 5.1),
+ * so concurrent calls never share counters. Sequence and timestamp both derive from one
+ * atomic frame counter, so sending needs no lock. The track and payload type are set
+ * during setup and negotiation; WebRTC serializes those writes against senders.
+ */
+class PeerSession
+{
+public:
+    static constexpr int kRtpHeaderSize = 12;
+    static constexpr uint32_t kSamplesPerFrame = 960; // 20 ms at the 48 kHz Opus RTP clock
+    static constexpr int kMaxRtpPacketSize = kRtpHeaderSize + kMaxFrameBytes; // Header plus the biggest Opus frame
+
+    // An ssrc of 0 picks a random one
+    PeerSession(const QString &peerId, uint32_t ssrc, int payloadType);
+
+    const QString &peerId() const;
+    uint32_t ssrc() const;
+
+    int payloadType() const;
+    void setPayloadType(int payloadType);
+
+    std::shared_ptr<rtc::Track> track() const;
+    void setTrack(std::shared_ptr<rtc::Track> track);
+
+    // Sends one encoded frame as an RTP packet; returns false while the track is not open.
+    // The packet is built in a per-thread buffer, so this never allocates.
+    bool sendFrame(const unsigned char *payload, int size);
+
+    // Writes the next RTP packet of this stream for one frame into out (kMaxRtpPacketSize bytes)
+    // and returns its size, or 0 when the payload is too large
+    int writeRtpPacket(const unsigned char *payload, int size, unsigned char *out);
+
+    // Offset of the payload in a received RTP packet, past CSRCs and any header extension;
+    // -1 when the packet is too short to hold one
+    static int rtpPayloadOffset(const unsigned char *packet, int size);
+
+    RtcpSession &rtcp();
+
+private:
+    QString m_peerId;
+    uint32_t m_ssrc;
+    int m_payloadType;
+    uint16_t m_initialSequence;
+    uint32_t m_initialTimestamp;
+    std::atomic<uint32_t> m_framesSent{0};
+    std::shared_ptr<rtc::Track> m_track;
+    RtcpSession m_rtcp;
+};
+
+#endif // PEERSESSION_H
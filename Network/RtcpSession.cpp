@@ -0,0 +1,267 @@
+#include "RtcpSession.h"
+#include <QMutexLocker>
+#include <QtEndian>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+constexpr int kRtpHeaderSize = 12;
+constexpr int kReportBlockSize = 24;
+constexpr uint8_t kRtcpSenderReport = 200;
+constexpr uint8_t kRtcpReceiverReport = 201;
+constexpr uint8_t kRtcpSourceDescription = 202;
+constexpr char kCname[] = "phonecall";
+
+// Seconds between the NTP epoch (1900) and the Unix epoch (1970)
+constexpr uint64_t kNtpUnixOffset = 2208988800ULL;
+
+int64_t steadyMicros()
+{
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+// 64-bit NTP timestamp: seconds in the upper half, binary fraction in the lower
+uint64_t ntpNow()
+{
+    using namespace std::chrono;
+    const auto sinceEpoch = duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+    const uint64_t seconds = static_cast<uint64_t>(sinceEpoch / 1000000) + kNtpUnixOffset;
+    const uint64_t fraction = (static_cast<uint64_t>(sinceEpoch % 1000000) << 32) / 1000000;
+    return (seconds << 32) | fraction;
+}
+
+// Middle 32 bits of an NTP timestamp, the unit of LSR and DLSR (1/65536 s)
+uint32_t ntpMiddle(uint64_t ntp)
+{
+    return static_cast<uint32_t>(ntp >> 16);
+}
+
+void writeHeader(unsigned char *out, int count, uint8_t packetType, int totalBytes)
+{
+    out[0] = 0x80 | static_cast<unsigned char>(count);
+    out[1] = packetType;
+    qToBigEndian<quint16>(static_cast<quint16>(totalBytes / 4 - 1), out + 2);
+}
+
+} // namespace
+
+RtcpSession::RtcpSession(uint32_t localSsrc)
+    : m_localSsrc(localSsrc)
+{
+}
+
+/**
+ * Count an outgoing RTP packet for the next sender report.
+ */
+void RtcpSession::onRtpSent(int payloadBytes, uint32_t rtpTimestamp)
+{
+    QMutexLocker locker(&m_mutex);
+    ++m_packetsSent;
+    m_octetsSent += static_cast<uint32_t>(payloadBytes);
+    m_bytesSent += static_cast<uint64_t>(payloadBytes) + kRtpHeaderSize;
+    m_lastRtpTimestamp = rtpTimestamp;
+    m_sentSinceReport = true;
+}
+
+/**
+ * Update sequence tracking and interarrival jitter (RFC 3550 A.1, A.8).
+ */
+void RtcpSession::onRtpReceived(const unsigned char *packet, int size)
+{
+    if (size < kRtpHeaderSize || (packet[0] >> 6) != 2)
+        return;
+
+    const uint16_t seq = qFromBigEndian<quint16>(packet + 2);
+    const uint32_t timestamp = qFromBigEndian<quint32>(packet + 4);
+    const uint32_t ssrc = qFromBigEndian<quint32>(packet + 8);
+    const uint32_t arrival = static_cast<uint32_t>(steadyMicros() * kClockRate / 1000000);
+
+    QMutexLocker locker(&m_mutex);
+    if (!m_receiving || ssrc != m_remoteSsrc) {
+        // New or restarted source
+        m_receiving = true;
+        m_remoteSsrc = ssrc;
+        m_baseSeq = seq;
+        m_maxSeq = seq;
+        m_cycles = 0;
+        m_received = 0;
+        m_expectedPrior = 0;
+        m_receivedPrior = 0;
+        m_jitter = 0.0;
+    } else {
+        const uint16_t delta = static_cast<uint16_t>(seq - m_maxSeq);
+        if (delta < 3000) {
+            // In order, possibly with a gap; a smaller value means the counter wrapped
+            if (seq < m_maxSeq)
+                m_cycles += 65536;
+            m_maxSeq = seq;
+        }
+        // Otherwise a duplicate or a late packet, which still counts as received
+    }
+
+    const uint32_t transit = arrival - timestamp;
+    if (m_received > 0) {
+        const int32_t d = static_cast<int32_t>(transit - m_lastTransit);
+        m_jitter += (std::abs(static_cast<double>(d)) - m_jitter) / 16.0;
+    }
+    m_lastTransit = transit;
+
+    ++m_received;
+    m_bytesReceived += static_cast<uint64_t>(size);
+}
+
+/**
+ * Read SR and RR packets of a compound RTCP packet.
+ */
+void RtcpSession::onRtcpReceived(const unsigned char *packet, int size)
+{
+    const uint64_t now = ntpNow();
+    const int64_t nowUs = steadyMicros();
+
+    QMutexLocker locker(&m_mutex);
+    int offset = 0;
+    while (offset + 8 <= size) {
+        const unsigned char *header = packet + offset;
+        const int count = header[0] & 0x1f;
+        const uint8_t packetType = header[1];
+        const int length = (qFromBigEndian<quint16>(header + 2) + 1) * 4;
+        if ((header[0] >> 6) != 2 || offset + length > size)
+            break;
+
+        int blocks = -1;
+        if (packetType == kRtcpSenderReport && length >= 28) {
+            const uint64_t ntp = qFromBigEndian<quint64>(header + 8);
+            m_lastSrNtp = ntpMiddle(ntp);
+            m_lastSrArrivalUs = nowUs;
+            blocks = 28;
+        } else if (packetType == kRtcpReceiverReport) {
+            blocks = 8;
+        }
+
+        for (int i = 0; blocks >= 0 && i < count && blocks + (i + 1) * kReportBlockSize <= length; ++i) {
+            const unsigned char *block = header + blocks + i * kReportBlockSize;
+            if (qFromBigEndian<quint32>(block) != m_localSsrc)
+                continue;
+
+            m_remoteFractionLost = block[4] / 256.0;
+            const uint32_t lsr = qFromBigEndian<quint32>(block + 16);
+            const uint32_t dlsr = qFromBigEndian<quint32>(block + 20);
+            if (lsr != 0) {
+                const int32_t rtt = static_cast<int32_t>(ntpMiddle(now) - lsr - dlsr);
+                if (rtt >= 0)
+                    m_rttMs = rtt * 1000.0 / 65536.0;
+            }
+        }
+
+        offset += length;
+    }
+}
+
+/**
+ * Build SR (or RR) + SDES into out.
+ */
+int RtcpSession::buildReport(unsigned char *out, int capacity)
+{
+    const int cnameLength = static_cast<int>(sizeof(kCname) - 1);
+    const int sdesBytes = (8 + 2 + cnameLength + 1 + 3) / 4 * 4;
+
+    QMutexLocker locker(&m_mutex);
+    const bool sender = m_sentSinceReport;
+    const int blockCount = m_receiving ? 1 : 0;
+    const int reportBytes = (sender ? 28 : 8) + blockCount * kReportBlockSize;
+    if (reportBytes + sdesBytes > capacity)
+        return 0;
+
+    writeHeader(out, blockCount, sender ? kRtcpSenderReport : kRtcpReceiverReport, reportBytes);
+    qToBigEndian<quint32>(m_localSsrc, out + 4);
+
+    unsigned char *cursor = out + 8;
+    if (sender) {
+        qToBigEndian<quint64>(ntpNow(), cursor);
+        qToBigEndian<quint32>(m_lastRtpTimestamp, cursor + 8);
+        qToBigEndian<quint32>(m_packetsSent, cursor + 12);
+        qToBigEndian<quint32>(m_octetsSent, cursor + 16);
+        cursor += 20;
+        m_sentSinceReport = false;
+    }
+
+    if (blockCount) {
+        const uint32_t expected = expectedPackets();
+        const int32_t lost = std::clamp<int64_t>(static_cast<int64_t>(expected) - m_received, -0x800000, 0x7fffff);
+
+        const uint32_t expectedInterval = expected - m_expectedPrior;
+        const uint32_t receivedInterval = m_received - m_receivedPrior;
+        m_expectedPrior = expected;
+        m_receivedPrior = m_received;
+        const int64_t lostInterval = static_cast<int64_t>(expectedInterval) - receivedInterval;
+        const uint8_t fraction = (expectedInterval == 0 || lostInterval <= 0)
+                                     ? 0 : static_cast<uint8_t>(std::min<int64_t>(255, (lostInterval << 8) / expectedInterval));
+        m_localFractionLost = fraction / 256.0;
+
+        uint32_t dlsr = 0;
+        if (m_lastSrNtp != 0)
+            dlsr = static_cast<uint32_t>((steadyMicros() - m_lastSrArrivalUs) * 65536 / 1000000);
+
+        qToBigEndian<quint32>(m_remoteSsrc, cursor);
+        qToBigEndian<quint32>((static_cast<uint32_t>(fraction) << 24) | (static_cast<uint32_t>(lost) & 0xffffff), cursor + 4);
+        qToBigEndian<quint32>(m_cycles + m_maxSeq, cursor + 8);
+        qToBigEndian<quint32>(static_cast<uint32_t>(m_jitter), cursor + 12);
+        qToBigEndian<quint32>(m_lastSrNtp, cursor + 16);
+        qToBigEndian<quint32>(dlsr, cursor + 20);
+        cursor += kReportBlockSize;
+    }
+
+    // SDES with a single CNAME item; compound packets must carry one
+    std::memset(cursor, 0, sdesBytes);
+    writeHeader(cursor, 1, kRtcpSourceDescription, sdesBytes);
+    qToBigEndian<quint32>(m_localSsrc, cursor + 4);
+    cursor[8] = 1; // CNAME
+    cursor[9] = static_cast<unsigned char>(cnameLength);
+    std::memcpy(cursor + 10, kCname, cnameLength);
+
+    return reportBytes + sdesBytes;
+}
+
+CallStats RtcpSession::snapshot() const
+{
+    QMutexLocker locker(&m_mutex);
+    CallStats stats;
+    stats.packetsSent = m_packetsSent;
+    stats.bytesSent = m_bytesSent;
+    stats.packetsReceived = m_received;
+    stats.bytesReceived = m_bytesReceived;
+    stats.packetsLost = m_receiving ? std::max<int64_t>(0, static_cast<int64_t>(expectedPackets()) - m_received) : 0;
+    stats.fractionLost = std::max(m_localFractionLost, m_remoteFractionLost);
+    stats.jitterMs = m_jitter * 1000.0 / kClockRate;
+    stats.rttMs = m_rttMs;
+    stats.mos = estimateMos(stats.rttMs, stats.jitterMs, stats.fractionLost);
+    return stats;
+}
+
+bool RtcpSession::isRtcp(const unsigned char *packet, int size)
+{
+    return size >= 8 && packet[1] >= 192 && packet[1] <= 223;
+}
+
+/**
+ * Simplified ITU-T G.107 E-model, mapped to a MOS between 1 and 4.5.
+ */
+double RtcpSession::estimateMos(double rttMs, double jitterMs, double fractionLost)
+{
+    const double latency = (rttMs > 0.0 ? rttMs / 2.0 : 0.0) + 2.0 * jitterMs + 10.0;
+    double r = (latency < 160.0) ? 93.2 - latency / 40.0 : 93.2 - (latency - 120.0) / 10.0;
+    r -= 2.5 * fractionLost * 100.0;
+    r = std::clamp(r, 0.0, 100.0);
+
+    const double mos = 1.0 + 0.035 * r + 7.0e-6 * r * (r - 60.0) * (100.0 - r);
+    return std::clamp(mos, 1.0, 4.5);
+}
+
+uint32_t RtcpSession::expectedPackets() const
+{
+    return m_cycles + m_maxSeq - m_baseSeq + 1;
+}
@@ -0,0 +1,92 @@
+#ifndef RTCPSESSION_H
+#define RTCPSESSION_H
+
+#include <QMutex>
+#include <QString>
+#include <cstdint>
+
+/**
+ * Network health of one call, as published to QML.
+ */
+struct CallStats
+{
+    QString peerId;
+    quint64 packetsSent = 0;
+    quint64 bytesSent = 0;
+    quint64 packetsReceived = 0;
+    quint64 bytesReceived = 0;
+    qint64  packetsLost = 0;     // Cumulative loss on the incoming stream
+    double  fractionLost = 0.0;  // Worst of the local and remote-reported loss over the last interval, 0..1
+    double  jitterMs = 0.0;      // Interarrival jitter of the incoming stream
+    double  rttMs = -1.0;        // Round-trip time from RTCP, -1 until known
+    double  mos = 0.0;           // Estimated listening quality, 1..4.5
+
+    // Local encoder of the call, the same for every peer
+    int     encoderComplexity = 0;
+    double  encodeMs = 0.0;      // Smoothed opus_encode time per frame
+    quint64 lateFrames = 0;      // Frames encoded after their deadline
+};
+
+/**
+ * RTCP bookkeeping for one peer (RFC 3550).
+ *
+ * Media threads feed every sent and received packet in; the stats timer builds
+ * SR/RR reports and takes snapshots. All state sits behind one short-held mutex
+ * and no call allocates.
+ */
+class RtcpSession
+{
+public:
+    static constexpr int kClockRate = 48000; // Opus RTP clock
+
+    explicit RtcpSession(uint32_t localSsrc = 0);
+
+    void onRtpSent(int payloadBytes, uint32_t rtpTimestamp);
+    void onRtpReceived(const unsigned char *packet, int size);
+    void onRtcpReceived(const unsigned char *packet, int size);
+
+    // Writes a compound SR (or RR when nothing was sent) plus SDES; returns its size or 0
+    int buildReport(unsigned char *out, int capacity);
+
+    CallStats snapshot() const;
+
+    // RTP and RTCP share the track (RFC 5761); RTCP packet types occupy 192..223
+    static bool isRtcp(const unsigned char *packet, int size);
+
+    static double estimateMos(double rttMs, double jitterMs, double fractionLost);
+
+private:
+    uint32_t expectedPackets() const;
+
+    mutable QMutex m_mutex;
+    const uint32_t m_localSsrc; // Fixed for the session's lifetime, read without the lock
+
+    // Outgoing stream
+    uint32_t m_packetsSent = 0;
+    uint32_t m_octetsSent = 0;
+    uint64_t m_bytesSent = 0;
+    uint32_t m_lastRtpTimestamp = 0;
+    bool     m_sentSinceReport = false;
+
+    // Incoming stream (RFC 3550 appendix A.1 and A.8)
+    bool     m_receiving = false;
+    uint32_t m_remoteSsrc = 0;
+    uint16_t m_maxSeq = 0;
+    uint32_t m_cycles = 0;
+    uint32_t m_baseSeq = 0;
+    uint32_t m_received = 0;
+    uint64_t m_bytesReceived = 0;
+    uint32_t m_expectedPrior = 0;
+    uint32_t m_receivedPrior = 0;
+    uint32_t m_lastTransit = 0;
+    double   m_jitter = 0.0;          // In RTP timestamp units
+    double   m_localFractionLost = 0.0;
+
+    // Feedback from the remote side
+    uint32_t m_lastSrNtp = 0;         // Middle 32 bits of the last SR's NTP time
+    int64_t  m_lastSrArrivalUs = 0;
+    double   m_remoteFractionLost = 0.0;
+    double   m_rttMs = -1.0;
+};
+
+#endif // RTCPSESSION_H
@@ -4,25 +4,35 @@
 #include <QJsonObject>
 #include <QtWebSockets/QWebSocket>
 #include <QDebug>
+#include <QMetaMethod>
+#include <QReadLocker>
+#include <QWriteLocker>
+#include <algorithm>
+#include <cstring>
 
-#pragma pack(push, 1)
-struct RtpHeader {
-    uint8_t first;
-    uint8_t marker:1;
-    uint8_t payloadType:7;
-    uint16_t sequenceNumber;
-    uint32_t timestamp;
-    uint32_t ssrc;
-};
-#pragma pack(pop)
+namespace {
+
+// Send failures repeat at the frame rate; only the 1st, 2nd, 4th, 8th... is logged
+bool shouldLogFailure(std::atomic<quint64> &failures)
+{
+    const quint64 count = failures.fetch_add(1, std::memory_order_relaxed) + 1;
+    return (count & (count - 1)) == 0;
+}
+
+} // namespace
 
 // Constructor for WebRTC class
 WebRTC::WebRTC(QObject *parent)
     : QObject{parent},
-    m_timestamp(0),
     m_ssrc(0),
-    m_isOfferer(false)
+    m_isOfferer(false),
+    m_callStats(new CallStatsModel(this)),
+    m_statsTimer(new QTimer(this))
 {
+    // Reports and the QML model are refreshed from this thread; media threads only update counters
+    m_statsTimer->setInterval(kStatsIntervalMs);
+    connect(m_statsTimer, &QTimer::timeout, this, &WebRTC::publishStats);
+
     connect(this, &WebRTC::gatheringComplited, [this] (const QString &peerID) {
         m_localDescription = descriptionToJson(m_peerConnections[peerID]->localDescription().value());
 
@@ -52,12 +62,15 @@ void WebRTC::init(bool isOfferer)
     config.iceServers.push_back(rtc::IceServer("stun:stun.l.google.com:19302"));
     m_config = config;
 
-    // RTP settings
-    m_sequenceNumber = 0;
-    m_timestamp = 0;
+    // Receive buffers are allocated once here so incoming packets never touch the heap
+    m_receivePool = FramePool::create(64);
+
+    // RTP settings; sequence numbers and timestamps live in each peer's session
     setBitRate(48000);
     setPayloadType(111);
-    setSsrc(2);
+    setSsrc(0);
+
+    m_statsTimer->start();
 
     // Initialize WebSocket signaling client
     // m_signalingClient = new SignalingClient("ws://localhost:3000", this);
@@ -77,6 +90,20 @@ void WebRTC::addPeer(const QString &peerId)
     auto newPeer = std::make_shared<rtc::PeerConnection>(m_config);
     m_peerConnections[peerId] = newPeer;
 
+    // A re-added peer starts a fresh RTP stream
+    auto session = std::make_shared<PeerSession>(peerId, ssrc(), payloadType());
+    {
+        QWriteLocker locker(&m_sessionsLock);
+        auto key = std::lower_bound(m_sessionIds.begin(), m_sessionIds.end(), peerId);
+        const auto index = key - m_sessionIds.begin();
+        if (key != m_sessionIds.end() && *key == peerId) {
+            m_sessions[index] = session;
+        } else {
+            m_sessionIds.insert(key, peerId);
+            m_sessions.insert(m_sessions.begin() + index, session);
+        }
+    }
+
     // Callback for local SDP generation
     newPeer->onLocalDescription([this, peerId](const rtc::Description &description) {
         QString sdp = descriptionToJson(description);
@@ -110,18 +137,24 @@ void WebRTC::addPeer(const QString &peerId)
         }
     });
 
-    // Callback for incoming track messages (assume audio track)
-    newPeer->onTrack([this, peerId](std::shared_ptr<rtc::Track> track) {
-        track->onMessage([this, peerId](rtc::message_variant data) {
-            QByteArray audioData = readVariant(data);
-            Q_EMIT incommingPacket(peerId, audioData, audioData.size());
-        });
+    // Callback for tracks opened by the remote side (assume audio track)
+    newPeer->onTrack([this, weakSession = std::weak_ptr<PeerSession>(session)](std::shared_ptr<rtc::Track> track) {
+        if (auto session = weakSession.lock())
+            attachTrack(session, std::move(track), false);
     });
 
     // Add an audio track
     addAudioTrack(peerId, "audio_track");
 }
 
+/**
+ * Check whether a peer connection exists.
+ */
+bool WebRTC::hasPeer(const QString &peerId) const
+{
+    return m_peerConnections.contains(peerId);
+}
+
 /**
  * Generate an SDP offer.
  */
@@ -147,12 +180,53 @@ void WebRTC::generateAnswerSDP(const QString &peerId)
  */
 void WebRTC::addAudioTrack(const QString &peerId, const QString &trackName)
 {
-    auto track = m_peerConnections[peerId]->addTrack(trackName.toStdString());
+    auto connection = m_peerConnections.value(peerId);
+    std::shared_ptr<PeerSession> session;
+    {
+        QReadLocker locker(&m_sessionsLock);
+        if (auto found = findSession(peerId))
+            session = *found;
+    }
+    if (!connection || !session) {
+        qWarning() << "Cannot add an audio track for unknown peer:" << peerId;
+        return;
+    }
 
-    track->onMessage([this, peerId](rtc::message_variant data) {
-        QByteArray audioData = readVariant(data);
-        Q_EMIT incommingPacket(peerId, audioData, audioData.size());
+    // Announce Opus and this peer's SSRC so the remote side can match RTP and RTCP to the stream
+    const std::string mid = trackName.toStdString();
+    rtc::Description::Audio media(mid, rtc::Description::Direction::SendRecv);
+    media.addOpusCodec(session->payloadType());
+    media.addSSRC(session->ssrc(), std::string("phonecall"), std::string("phonecall"), mid);
+
+    attachTrack(session, connection->addTrack(media), true);
+}
+
+/**
+ * Route a track's messages to the peer's session and, if needed, send on it.
+ */
+void WebRTC::attachTrack(const std::shared_ptr<PeerSession> &session, std::shared_ptr<rtc::Track> track, bool replaceExisting)
+{
+    // The track owns this callback, so it must not keep the session alive
+    track->onMessage([this, weakSession = std::weak_ptr<PeerSession>(session)](rtc::message_variant data) {
+        if (auto session = weakSession.lock())
+            handleTrackMessage(*session, data);
     });
+
+    QWriteLocker locker(&m_sessionsLock);
+    if (replaceExisting || !session->track())
+        session->setTrack(std::move(track));
+}
+
+/**
+ * Find a peer's session. The search only touches the sorted id vector;
+ * the session itself is read once, on a hit.
+ */
+const std::shared_ptr<PeerSession> *WebRTC::findSession(const QString &peerId) const
+{
+    auto key = std::lower_bound(m_sessionIds.cbegin(), m_sessionIds.cend(), peerId);
+    if (key != m_sessionIds.cend() && *key == peerId)
+        return &m_sessions[key - m_sessionIds.cbegin()];
+    return nullptr;
 }
 
 /**
@@ -160,30 +234,158 @@ void WebRTC::addAudioTrack(const QString &peerId, const QString &trackName)
  */
 void WebRTC::sendTrack(const QString &peerId, const QByteArray &buffer)
 {
-    RtpHeader rtpHeader;
-    rtpHeader.first = 0x80;
-    rtpHeader.marker = 1;
-    rtpHeader.payloadType = payloadType();
-    rtpHeader.sequenceNumber = qToBigEndian(m_sequenceNumber++);
-    rtpHeader.timestamp = qToBigEndian(m_timestamp += 160);
-    rtpHeader.ssrc = qToBigEndian(ssrc());
+    sendPayload(peerId, reinterpret_cast<const unsigned char*>(buffer.constData()), buffer.size());
+}
+
+/**
+ * Send a pooled frame as an RTP packet without building a QByteArray.
+ */
+void WebRTC::sendFrame(const QString &peerId, const AudioFrame &frame)
+{
+    sendPayload(peerId, frame.data, frame.size);
+}
+
+/**
+ * Register the receiver of incoming RTP payloads; called on libdatachannel threads.
+ */
+void WebRTC::setIncomingFrameSink(std::function<void(const QString &, FrameHandle)> sink)
+{
+    // Track threads call the sink under the read lock, so once this returns no call is in flight
+    QWriteLocker locker(&m_sessionsLock);
+    m_incomingFrameSink = std::move(sink);
+}
 
-    // Build RTP packet by combining header and audio data
-    QByteArray packet(reinterpret_cast<char*>(&rtpHeader), sizeof(RtpHeader));
-    packet.append(buffer);
+/**
+ * Send one encoded frame on the peer's own RTP stream.
+ */
+void WebRTC::sendPayload(const QString &peerId, const unsigned char *payload, int size)
+{
+    if (size > kMaxFrameBytes) {
+        if (shouldLogFailure(m_sendFailures))
+            qWarning() << "Payload too large for an RTP packet:" << size;
+        return;
+    }
+
+    // Shared lock: senders for different peers run in parallel, only setup waits
+    QReadLocker locker(&m_sessionsLock);
+    auto found = findSession(peerId);
+    if (!found) {
+        if (shouldLogFailure(m_sendFailures))
+            qWarning() << "No session for peer:" << peerId;
+        return;
+    }
 
     try {
-        if (m_peerTracks.contains(peerId)) {
-            auto &track = m_peerTracks[peerId];
-            track->send(reinterpret_cast<const std::byte*>(packet.data()), packet.size());
-        } else {
-            qWarning() << "Audio track not found for peer:" << peerId;
-        }
+        // Frames before the track opens are dropped; nothing is connected yet to hear them
+        (*found)->sendFrame(payload, size);
     } catch (const std::exception &e) {
-        qWarning() << "Failed to send RTP packet over audio track:" << e.what();
+        if (shouldLogFailure(m_sendFailures))
+            qWarning() << "Failed to send RTP packet over audio track:" << e.what() << "-" << m_sendFailures.load() << "failures so far";
     }
 }
 
+/**
+ * Raise the legacy signal if anyone listens and pass binary messages on to the receive path.
+ */
+void WebRTC::handleTrackMessage(PeerSession &session, const rtc::message_variant &data)
+{
+    const QString &peerId = session.peerId();
+
+    // The legacy signal needs its own QByteArray; skip that copy when nobody listens
+    if (isSignalConnected(QMetaMethod::fromSignal(&WebRTC::incommingPacket))) {
+        QByteArray audioData = readVariant(data);
+        Q_EMIT incommingPacket(peerId, audioData, audioData.size());
+    }
+
+    if (auto binaryData = std::get_if<rtc::binary>(&data))
+        deliverPacket(session, reinterpret_cast<const unsigned char*>(binaryData->data()), static_cast<int>(binaryData->size()));
+}
+
+/**
+ * Feed one packet to a peer's receive path as if its track had delivered it.
+ */
+void WebRTC::deliverIncoming(const QString &peerId, const unsigned char *bytes, int size)
+{
+    // Copied out so the lock is not held twice; deliverPacket takes it again for the sink
+    std::shared_ptr<PeerSession> session;
+    {
+        QReadLocker locker(&m_sessionsLock);
+        if (auto found = findSession(peerId))
+            session = *found;
+    }
+    if (session)
+        deliverPacket(*session, bytes, size);
+}
+
+/**
+ * Route RTCP to the statistics and hand the RTP payload to the sink in a pooled frame.
+ */
+void WebRTC::deliverPacket(PeerSession &session, const unsigned char *bytes, int size)
+{
+    // RTCP arrives on the same track; it feeds the statistics and never reaches the decoder
+    if (RtcpSession::isRtcp(bytes, size)) {
+        session.rtcp().onRtcpReceived(bytes, size);
+        return;
+    }
+    session.rtcp().onRtpReceived(bytes, size);
+
+    QReadLocker locker(&m_sessionsLock); // Guards m_incomingFrameSink
+    if (!m_incomingFrameSink || !m_receivePool)
+        return;
+
+    // Skip the fixed header, CSRC list and header extension to reach the Opus payload
+    const int headerSize = PeerSession::rtpPayloadOffset(bytes, size);
+    if (headerSize < 0)
+        return;
+    const int payloadSize = size - headerSize;
+    if (payloadSize <= 0 || payloadSize > kMaxFrameBytes)
+        return;
+
+    FrameHandle frame = m_receivePool->acquire();
+    if (!frame)
+        return; // Consumer is far behind; dropping beats allocating
+
+    std::memcpy(frame->data, bytes + headerSize, payloadSize);
+    frame->size = payloadSize;
+    m_incomingFrameSink(session.peerId(), std::move(frame));
+}
+
+/**
+ * Send an RTCP report to every peer and refresh the stats model.
+ */
+void WebRTC::publishStats()
+{
+    unsigned char report[256];
+    QVector<CallStats> stats;
+    const EncoderStats encoder = m_encoderStatsProvider ? m_encoderStatsProvider() : EncoderStats();
+
+    {
+        QReadLocker locker(&m_sessionsLock);
+        stats.reserve(static_cast<int>(m_sessions.size()));
+        for (const auto &session : m_sessions) {
+            auto track = session->track();
+            if (track && track->isOpen()) {
+                const int size = session->rtcp().buildReport(report, sizeof(report));
+                try {
+                    if (size > 0)
+                        track->send(reinterpret_cast<const std::byte*>(report), size);
+                } catch (const std::exception &e) {
+                    qWarning() << "Failed to send RTCP report:" << e.what();
+                }
+            }
+
+            CallStats peerStats = session->rtcp().snapshot();
+            peerStats.peerId = session->peerId();
+            peerStats.encoderComplexity = encoder.complexity;
+            peerStats.encodeMs = encoder.encodeMs;
+            peerStats.lateFrames = encoder.lateFrames;
+            stats.append(peerStats);
+        }
+    }
+
+    m_callStats->setStats(stats);
+}
+
 /**
  * Set the remote SDP description.
  */
@@ -192,9 +394,36 @@ void WebRTC::setRemoteDescription(const QString &peerID, const QString &sdp)
     if (m_peerConnections.contains(peerID)) {
         rtc::Description description(sdp.toStdString(), m_isOfferer ? rtc::Description::Type::Answer : rtc::Description::Type::Offer);
         m_peerConnections[peerID]->setRemoteDescription(description);
+
+        // Send with the payload type the remote side chose for Opus
+        const int negotiated = negotiatedOpusPayloadType(description);
+        if (negotiated >= 0) {
+            QWriteLocker locker(&m_sessionsLock);
+            if (auto found = findSession(peerID))
+                (*found)->setPayloadType(negotiated);
+        }
     }
 }
 
+/**
+ * Find the Opus payload type in a description, or -1 when there is none.
+ */
+int WebRTC::negotiatedOpusPayloadType(rtc::Description &description)
+{
+    for (int i = 0; i < description.mediaCount(); ++i) {
+        auto entry = description.media(i);
+        auto *media = std::get_if<rtc::Description::Media *>(&entry);
+        if (!media || (*media)->type() != "audio")
+            continue;
+        for (int payloadType : (*media)->payloadTypes()) {
+            const auto *map = (*media)->rtpMap(payloadType);
+            if (map && QString::fromStdString(map->format).compare(QLatin1String("opus"), Qt::CaseInsensitive) == 0)
+                return payloadType;
+        }
+    }
+    return -1;
+}
+
 /**
  * Add a remote ICE candidate.
  */
@@ -229,6 +458,22 @@ QString WebRTC::descriptionToJson(const rtc::Description &description)
     return doc.toJson(QJsonDocument::Compact);
 }
 
+/**
+ * Set where the stats timer reads the local encoder's figures from.
+ */
+void WebRTC::setEncoderStatsProvider(std::function<EncoderStats()> provider)
+{
+    m_encoderStatsProvider = std::move(provider);
+}
+
+/**
+ * Get the per-peer call statistics model.
+ */
+CallStatsModel *WebRTC::callStats() const
+{
+    return m_callStats;
+}
+
 /**
  * Get the bit rate.
  */
@@ -280,7 +525,7 @@ void WebRTC::resetPayloadType()
 }
 
 /**
- * Get SSRC.
+ * Get the SSRC for new peers; 0 means random per peer.
  */
 rtc::SSRC WebRTC::ssrc() const
 {
@@ -288,7 +533,7 @@ rtc::SSRC WebRTC::ssrc() const
 }
 
 /**
- * Set SSRC.
+ * Set the SSRC for new peers; existing sessions keep theirs.
  */
 void WebRTC::setSsrc(rtc::SSRC newSsrc)
 {
@@ -297,11 +542,21 @@ void WebRTC::setSsrc(rtc::SSRC newSsrc)
 }
 
 /**
- * Reset SSRC to default.
+ * Reset SSRC to default (random per peer).
  */
 void WebRTC::resetSsrc()
 {
-    setSsrc(2);
+    setSsrc(0);
+}
+
+/**
+ * Get the SSRC of a peer's outgoing stream.
+ */
+rtc::SSRC WebRTC::peerSsrc(const QString &peerId) const
+{
+    QReadLocker locker(&m_sessionsLock);
+    auto found = findSession(peerId);
+    return found ? (*found)->ssrc() : 0;
 }
 
 /**
@@ -3,7 +3,17 @@
 
 #include <QObject>
 #include <QMap>
+#include <QReadWriteLock>
+#include <QTimer>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
 #include <rtc/rtc.hpp>
+#include "CallStatsModel.h"
+#include "ComplexityController.h"
+#include "FramePool.h"
+#include "PeerSession.h"
 class WebRTC : public QObject
 {
     Q_OBJECT
@@ -14,19 +24,31 @@ public:
 
     Q_INVOKABLE void init(bool isOfferer = false);
     Q_INVOKABLE void addPeer(const QString &peerId);
+    Q_INVOKABLE bool hasPeer(const QString &peerId) const;
     Q_INVOKABLE void generateOfferSDP(const QString &peerId);
     Q_INVOKABLE void generateAnswerSDP(const QString &peerId);
     Q_INVOKABLE void addAudioTrack(const QString &peerId, const QString &trackName);
     Q_INVOKABLE void sendTrack(const QString &peerId, const QByteArray &buffer);
 
+    // Allocation-free media path used once a call is set up
+    void sendFrame(const QString &peerId, const AudioFrame &frame);
+    void setIncomingFrameSink(std::function<void(const QString &peerId, FrameHandle frame)> sink);
+    // Receive path of a track message without the track; tests feed packets through it
+    void deliverIncoming(const QString &peerId, const unsigned char *bytes, int size);
+
     bool isOfferer() const;
     void setIsOfferer(bool newIsOfferer);
     void resetIsOfferer();
 
+    // SSRC given to peers added from now on; 0 (the default) gives each peer a random one
     rtc::SSRC ssrc() const;
     void setSsrc(rtc::SSRC newSsrc);
     void resetSsrc();
 
+    // SSRC the given peer's outgoing stream uses, or 0 for an unknown peer
+    Q_INVOKABLE rtc::SSRC peerSsrc(const QString &peerId) const;
+
+    // Payload type offered to new peers; each session switches to the one the remote side negotiates
     int payloadType() const;
     void setPayloadType(int newPayloadType);
     void resetPayloadType();
@@ -35,6 +57,10 @@ public:
     void setBitRate(int newBitRate);
     void resetBitRate();
 
+    CallStatsModel *callStats() const;
+    // Source of the encoder figures shown next to each peer's network stats; polled by the stats timer
+    void setEncoderStatsProvider(std::function<EncoderStats()> provider);
+
 Q_SIGNALS:
     void openedDataChannel(const QString &peerId);
     void closedDataChannel(const QString &peerId);
@@ -57,6 +83,15 @@ public Q_SLOTS:
 
 private:
     QByteArray readVariant(const rtc::message_variant &data);
+    void handleTrackMessage(PeerSession &session, const rtc::message_variant &data);
+    void deliverPacket(PeerSession &session, const unsigned char *bytes, int size);
+    void publishStats();
+    void sendPayload(const QString &peerId, const unsigned char *payload, int size);
+    void attachTrack(const std::shared_ptr<PeerSession> &session, std::shared_ptr<rtc::Track> track, bool replaceExisting);
+
+    // Binary search in m_sessionIds; callers hold m_sessionsLock. Null for an unknown peer.
+    const std::shared_ptr<PeerSession> *findSession(const QString &peerId) const;
+    static int negotiatedOpusPayloadType(rtc::Description &description);
     QString descriptionToJson(const rtc::Description &description);
 
     inline uint32_t getCurrentTimestamp() {
@@ -67,28 +102,39 @@ private:
     }
 
 private:
-    static inline uint16_t                              m_sequenceNumber = 0;
-    static inline uint32_t                              m_instanceCounter = 0;
     bool                                                m_gatheringComplited = false;
     int                                                 m_bitRate = 48000;
     int                                                 m_payloadType = 111;
     rtc::Description::Audio                             m_audio;
-    rtc::SSRC                                           m_ssrc = 2;
+    rtc::SSRC                                           m_ssrc = 0;
     bool                                                m_isOfferer = false;
     QString                                             m_localId;
     rtc::Configuration                                  m_config;
-    QMap<QString, rtc::Description>                     m_peerSdps;
     QMap<QString, std::shared_ptr<rtc::PeerConnection>> m_peerConnections;
-    QMap<QString, std::shared_ptr<rtc::Track>>          m_peerTracks;
     QString                                             m_localDescription;
     QString                                             m_remoteDescription;
 
-    uint32_t                                            m_timestamp = 0; // Added missing m_timestamp declaration
+    std::shared_ptr<FramePool>                          m_receivePool;
+    std::function<void(const QString &, FrameHandle)>   m_incomingFrameSink; // Under m_sessionsLock
+    // Media state per peer, sorted by peer id: one binary search per sent packet.
+    // The ids sit in their own vector so the search never dereferences a session;
+    // m_sessions[i] belongs to m_sessionIds[i].
+    // Media threads read under the lock; setup and negotiation write under it.
+    std::vector<QString>                                m_sessionIds;
+    std::vector<std::shared_ptr<PeerSession>>           m_sessions;
+    mutable QReadWriteLock                              m_sessionsLock;
+    CallStatsModel                                     *m_callStats = nullptr;
+    std::function<EncoderStats()>                       m_encoderStatsProvider;
+    std::atomic<quint64>                                m_sendFailures{0}; // Frames that could not be sent; logged sparsely
+    QTimer                                             *m_statsTimer = nullptr;
+
+    static constexpr int                                kStatsIntervalMs = 1000;
 
     Q_PROPERTY(bool isOfferer READ isOfferer WRITE setIsOfferer RESET resetIsOfferer NOTIFY isOffererChanged FINAL)
     Q_PROPERTY(rtc::SSRC ssrc READ ssrc WRITE setSsrc RESET resetSsrc NOTIFY ssrcChanged FINAL)
     Q_PROPERTY(int payloadType READ payloadType WRITE setPayloadType RESET resetPayloadType NOTIFY payloadTypeChanged FINAL)
     Q_PROPERTY(int bitRate READ bitRate WRITE setBitRate RESET resetBitRate NOTIFY bitRateChanged FINAL)
+    Q_PROPERTY(CallStatsModel *callStats READ callStats CONSTANT FINAL)
 };
 
 #endif // WEBRTC_H
@@ -0,0 +1,18 @@
+# Headless endpoint for servers: QCoreApplication only, no QML, Widgets or display.
+# Qt Multimedia still links QtGui as a library, but no GUI application or platform plugin is created.
+QT        = core multimedia network websockets
+CONFIG   += console
+CONFIG   -= app_bundle
+TARGET    = PhoneCallDaemon
+
+include(common.pri)
+
+# Source and header files
+SOURCES += \
+    DaemonConfig.cpp \
+    DaemonMain.cpp \
+    StdioSignaling.cpp
+
+HEADERS += \
+    DaemonConfig.h \
+    StdioSignaling.h
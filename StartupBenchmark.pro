@@ -0,0 +1,10 @@
+# Runs PhoneCallApp several times in startup benchmark mode and reports
+# time to interactive and time to first frame. Needs no audio or network libraries.
+QT        = core
+CONFIG   += c++17 console
+CONFIG   -= app_bundle
+TARGET    = StartupBenchmark
+
+# Source files
+SOURCES += \
+    StartupBenchmark.cpp
@@ -0,0 +1,83 @@
+#include <QtTest>
+#include <chrono>
+#include "ComplexityController.h"
+
+using namespace std::chrono_literals;
+
+/**
+ * Drives ComplexityController with synthetic per-frame timings.
+ */
+class ComplexityControllerTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void burstyInputOnIdleHostKeepsComplexity();
+    void sustainedLoadStepsDownToFloor();
+    void headroomRaisesBackToInitial();
+    void resetRestoresInitialState();
+};
+
+// A device that delivers 100 ms per write completes five frames at once. They are encoded back
+// to back, so the k-th frame of a burst waits for the k-1 encodes before it, never for the 80 ms
+// its first samples sat in the device buffer.
+void ComplexityControllerTest::burstyInputOnIdleHostKeepsComplexity()
+{
+    ComplexityController controller;
+    const auto encodeTime = 1500us;
+    for (int burst = 0; burst < 200; ++burst) {
+        for (int k = 0; k < 5; ++k)
+            QCOMPARE(controller.update(encodeTime, encodeTime * (k + 1)), 9);
+    }
+
+    const EncoderStats stats = controller.snapshot();
+    QCOMPARE(stats.framesEncoded, uint64_t(1000));
+    QCOMPARE(stats.lateFrames, uint64_t(0));
+    QCOMPARE(stats.complexityDrops, 0);
+    QVERIFY(stats.budgetUsage < 0.5);
+}
+
+void ComplexityControllerTest::sustainedLoadStepsDownToFloor()
+{
+    ComplexityController controller;
+    for (int i = 0; i < 200; ++i)
+        controller.update(12ms, 15ms);
+
+    const EncoderStats stats = controller.snapshot();
+    QCOMPARE(stats.complexity, ComplexityController::kMinComplexity);
+    QCOMPARE(stats.complexityDrops, 9 - ComplexityController::kMinComplexity);
+    QCOMPARE(stats.lateFrames, uint64_t(0));
+}
+
+void ComplexityControllerTest::headroomRaisesBackToInitial()
+{
+    ComplexityController controller;
+    for (int i = 0; i < 20; ++i)
+        controller.update(18ms, 25ms); // Late frames
+    QVERIFY(controller.complexity() < 9);
+    QCOMPARE(controller.snapshot().lateFrames, uint64_t(20));
+
+    for (int i = 0; i < 5000; ++i)
+        controller.update(1ms, 2ms);
+
+    const EncoderStats stats = controller.snapshot();
+    QCOMPARE(stats.complexity, 9); // Back to the start, never above it
+    QCOMPARE(stats.complexityRaises, stats.complexityDrops);
+}
+
+void ComplexityControllerTest::resetRestoresInitialState()
+{
+    ComplexityController controller(20ms, 7);
+    for (int i = 0; i < 50; ++i)
+        controller.update(18ms, 25ms);
+    QVERIFY(controller.complexity() < 7);
+
+    controller.reset();
+    const EncoderStats stats = controller.snapshot();
+    QCOMPARE(stats.complexity, 7);
+    QCOMPARE(stats.framesEncoded, uint64_t(0));
+    QCOMPARE(stats.complexityDrops, 0);
+}
+
+QTEST_APPLESS_MAIN(ComplexityControllerTest)
+#include "tst_ComplexityController.moc"
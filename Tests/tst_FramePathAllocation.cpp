@@ -0,0 +1,184 @@
+#include <QtTest>
+#include <QAudioDevice>
+#include <QtEndian>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <thread>
+#include "AudioInput.h"
+#include "AudioOutput.h"
+#include "FramePool.h"
+#include "PeerSession.h"
+#include "webRTC.h"
+
+namespace {
+
+constexpr double kPi = 3.14159265358979323846;
+
+std::atomic<bool> g_counting{false};
+std::atomic<int> g_allocations{0};
+
+template <typename Predicate>
+bool waitFor(Predicate ready)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+    while (!ready()) {
+        if (std::chrono::steady_clock::now() > deadline)
+            return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+    return true;
+}
+
+} // namespace
+
+// Every plain heap allocation in the process goes through here, codec workers included
+void *operator new(std::size_t size)
+{
+    if (g_counting.load(std::memory_order_relaxed))
+        g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *memory = std::malloc(size ? size : 1))
+        return memory;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete[](void *memory, std::size_t) noexcept
+{
+    std::free(memory);
+}
+
+/**
+ * Drives one frame at a time through capture -> encode -> RTP send -> RTP receive
+ * -> decode -> playout, with no devices and no network, and checks that a warmed-up
+ * pipeline never touches the heap.
+ *
+ * Sending goes through WebRTC::sendFrame and receiving through WebRTC::deliverIncoming,
+ * the same path a track message takes. Not covered: the track itself (libdatachannel's
+ * send and receive) and the QByteArray-based incommingPacket signal, which only legacy
+ * listeners use.
+ */
+class FramePathAllocationTest : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+    void initTestCase();
+    void cleanupTestCase();
+    void steadyStateDoesNotAllocate();
+
+private:
+    bool runFrames(int count);
+
+    std::unique_ptr<AudioOutput> output;
+    std::unique_ptr<AudioInput> input;
+    std::unique_ptr<WebRTC> webRTC;
+    std::unique_ptr<PeerSession> sender; // Stands in for the remote side's outgoing stream
+    std::atomic<int> received{0};
+    std::atomic<int> lost{0};
+
+    char tone[960 * sizeof(opus_int16)];     // One 20 ms capture frame
+    char playback[960 * sizeof(opus_int16)]; // One 20 ms frame pulled by the "sink"
+    unsigned char packet[PeerSession::kMaxRtpPacketSize];
+};
+
+void FramePathAllocationTest::initTestCase()
+{
+    // A 440 Hz tone gives Opus real work; silence would encode to a few bytes
+    auto *samples = reinterpret_cast<opus_int16 *>(tone);
+    for (int i = 0; i < 960; ++i)
+        samples[i] = static_cast<opus_int16>(8000.0 * std::sin(2.0 * kPi * 440.0 * i / 48000.0));
+
+    // Null devices: capture is fed through write() and playback is pulled through read()
+    output = std::make_unique<AudioOutput>(QAudioDevice());
+    input = std::make_unique<AudioInput>(QAudioDevice());
+    sender = std::make_unique<PeerSession>(QStringLiteral("local"), 0, 111);
+
+    // A peer with no track: sends are looked up and dropped, packets are fed in by hand
+    webRTC = std::make_unique<WebRTC>();
+    webRTC->init();
+    webRTC->addPeer(QStringLiteral("remote"));
+    webRTC->setIncomingFrameSink([this](const QString &, FrameHandle frame) {
+        received.fetch_add(1);
+        output->addFrame(std::move(frame));
+    });
+
+    input->setEncodedFrameSink([this](FrameHandle encoded) {
+        webRTC->sendFrame(QStringLiteral("remote"), *encoded);
+
+        // What the open track would have carried: the packet PeerSession::sendFrame builds
+        const int packetSize = sender->writeRtpPacket(encoded->data, encoded->size, packet);
+        sender->rtcp().onRtpSent(encoded->size, qFromBigEndian<quint32>(packet + 4));
+        encoded.reset();
+        if (packetSize == 0) {
+            lost.fetch_add(1);
+            return;
+        }
+        webRTC->deliverIncoming(QStringLiteral("remote"), packet, packetSize);
+    });
+}
+
+void FramePathAllocationTest::cleanupTestCase()
+{
+    input.reset(); // Its encode jobs call into webRTC and output
+    webRTC.reset();
+    output.reset();
+}
+
+bool FramePathAllocationTest::runFrames(int count)
+{
+    for (int i = 0; i < count; ++i) {
+        if (input->write(tone, sizeof(tone)) != sizeof(tone))
+            return false;
+        if (!waitFor([this]() { return output->queuedSamples() >= 960; }))
+            return false;
+        if (output->read(playback, sizeof(playback)) != sizeof(playback))
+            return false;
+    }
+    return true;
+}
+
+void FramePathAllocationTest::steadyStateDoesNotAllocate()
+{
+    // Warm-up: lazy codec, thread and pool state is created here
+    QVERIFY(runFrames(50));
+
+    constexpr int kFrames = 200;
+    const int receivedBefore = received.load();
+    g_allocations = 0;
+    g_counting = true;
+    const bool ok = runFrames(kFrames);
+    g_counting = false;
+
+    QVERIFY(ok);
+    QCOMPARE(received.load() - receivedBefore, kFrames);
+    QCOMPARE(lost.load(), 0);
+    QCOMPARE(input->droppedFrames(), 0);
+    QCOMPARE(output->droppedFrames(), 0);
+    QCOMPARE(g_allocations.load(), 0);
+}
+
+QTEST_GUILESS_MAIN(FramePathAllocationTest)
+#include "tst_FramePathAllocation.moc"
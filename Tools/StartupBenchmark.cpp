@@ -0,0 +1,128 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QProcess>
+#include <QProcessEnvironment>
+#include <QRegularExpression>
+#include <QTextStream>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+namespace {
+
+struct Summary
+{
+    double min = 0.0;
+    double median = 0.0;
+    double mean = 0.0;
+    double max = 0.0;
+};
+
+Summary summarize(std::vector<double> values)
+{
+    Summary summary;
+    if (values.empty())
+        return summary;
+
+    std::sort(values.begin(), values.end());
+    const size_t middle = values.size() / 2;
+    summary.min = values.front();
+    summary.max = values.back();
+    summary.median = values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2.0;
+    summary.mean = std::accumulate(values.begin(), values.end(), 0.0) / values.size();
+    return summary;
+}
+
+} // namespace
+
+/**
+ * Start the app repeatedly with PHONECALL_STARTUP_BENCHMARK set and collect the
+ * STARTUP_METRICS line each run prints before it exits.
+ *
+ *   StartupBenchmark --runs 10 --csv startup.csv ./PhoneCallApp
+ */
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("StartupBenchmark");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measures time to interactive and time to first frame of PhoneCallApp over several runs.");
+    parser.addHelpOption();
+    const QCommandLineOption runsOption("runs", "Number of runs (default 5).", "count", "5");
+    const QCommandLineOption timeoutOption("timeout", "Give up on a run after this long (default 30000).", "ms", "30000");
+    const QCommandLineOption csvOption("csv", "Append one row per run to a CSV file.", "file");
+    parser.addOptions({runsOption, timeoutOption, csvOption});
+    parser.addPositionalArgument("app", "Path to PhoneCallApp.");
+    parser.addPositionalArgument("args", "Arguments passed to the app.", "[args...]");
+    parser.process(app);
+
+    const QStringList positional = parser.positionalArguments();
+    const int runs = parser.value(runsOption).toInt();
+    const int timeoutMs = parser.value(timeoutOption).toInt();
+    if (positional.isEmpty() || runs <= 0 || timeoutMs <= 0)
+        parser.showHelp(1); // Exits
+
+    QTextStream out(stdout);
+    QFile csv;
+    QTextStream csvOut;
+    if (parser.isSet(csvOption)) {
+        csv.setFileName(parser.value(csvOption));
+        const bool writeHeader = !csv.exists() || csv.size() == 0;
+        if (!csv.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+            qCritical().noquote() << "Cannot open" << csv.fileName() << ":" << csv.errorString();
+            return 1;
+        }
+        csvOut.setDevice(&csv);
+        if (writeHeader)
+            csvOut << "run,interactive_ms,first_frame_ms\n";
+    }
+
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+    environment.insert("PHONECALL_STARTUP_BENCHMARK", "1");
+    const QRegularExpression metrics("STARTUP_METRICS interactive_ms=(-?\\d+) first_frame_ms=(\\d+)");
+
+    std::vector<double> interactive;
+    std::vector<double> firstFrame;
+    int failures = 0;
+    for (int run = 1; run <= runs; ++run) {
+        QProcess process;
+        process.setProcessEnvironment(environment);
+        process.setProcessChannelMode(QProcess::MergedChannels); // qInfo goes to stderr
+        process.start(positional.first(), positional.mid(1));
+
+        const bool finished = process.waitForFinished(timeoutMs);
+        if (!finished) {
+            process.kill();
+            process.waitForFinished();
+        }
+
+        const QRegularExpressionMatch match = metrics.match(QString::fromLocal8Bit(process.readAll()));
+        if (!finished || process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0 || !match.hasMatch()) {
+            out << "run " << run << ": failed" << (finished ? "" : " (timed out)") << Qt::endl;
+            ++failures;
+            continue;
+        }
+
+        const double interactiveMs = match.captured(1).toDouble();
+        const double firstFrameMs = match.captured(2).toDouble();
+        interactive.push_back(interactiveMs);
+        firstFrame.push_back(firstFrameMs);
+        out << "run " << run << ": interactive " << interactiveMs << " ms, first frame " << firstFrameMs << " ms" << Qt::endl;
+        if (csvOut.device())
+            csvOut << run << ',' << interactiveMs << ',' << firstFrameMs << '\n';
+    }
+
+    auto report = [&out](const char *name, const std::vector<double> &values) {
+        const Summary summary = summarize(values);
+        out << name << ": min " << summary.min << " / median " << summary.median
+            << " / mean " << summary.mean << " / max " << summary.max << " ms" << Qt::endl;
+    };
+    out << interactive.size() << " of " << runs << " runs succeeded" << Qt::endl;
+    if (!interactive.empty()) {
+        report("Time to interactive", interactive);
+        report("Time to first frame", firstFrame);
+    }
+    return failures == 0 ? 0 : 1;
+}
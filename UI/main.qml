@@ -21,12 +21,17 @@ Window {
             }
 
             Label{
-                text: "Ip: " + "172.16.142.176"
+                id: iplabel
+                property string ip: "-"
+                text: "Ip: " + ip
                 Layout.fillWidth: true
                 Layout.preferredHeight: 40
             }
             Label{
-                text: "IceCandidate: " + "172.16.142.176"
+                id: candidatelabel
+                property string candidate: "-"
+                text: "IceCandidate: " + candidate
+                elide: Text.ElideRight
                 Layout.fillWidth: true
                 Layout.preferredHeight: 40
             }
@@ -36,6 +41,39 @@ Window {
                 Layout.preferredHeight: 40
             }
 
+            // Live per-peer network health from RTCP
+            ListView{
+                model: webRTC.callStats
+                clip: true
+                Layout.fillWidth: true
+                Layout.fillHeight: true
+
+                delegate: Label{
+                    width: ListView.view.width
+                    wrapMode: Text.Wrap
+                    text: peerId
+                          + "\nLoss: " + (fractionLost * 100).toFixed(1) + "% (" + packetsLost + ")"
+                          + "  Jitter: " + jitterMs.toFixed(1) + " ms"
+                          + "\nRTT: " + (rttMs < 0 ? "-" : rttMs.toFixed(0) + " ms")
+                          + "  MOS: " + mos.toFixed(2)
+                          + "\nSent: " + packetsSent + " pkts / " + bytesSent + " B"
+                          + "\nReceived: " + packetsReceived + " pkts / " + bytesReceived + " B"
+                          + "\nEncoder: complexity " + encoderComplexity
+                          + "  " + encodeMs.toFixed(2) + " ms  Late: " + lateFrames
+                }
+            }
+
+        }
+
+        Connections{
+            target: webRTC
+            function onLocalCandidateGenerated(peerID, candidate, sdpMid){
+                // "candidate:<foundation> <component> <transport> <priority> <address> <port> typ <type>"
+                var fields = candidate.split(" ")
+                candidatelabel.candidate = candidate
+                if(fields.length > 4)
+                    iplabel.ip = fields[4]
+            }
         }
 
         TextField{
@@ -69,8 +107,10 @@ Window {
                 if(pushed){
                     Material.background = "red"
                     text = "End Call"
+                    audioApp.startRecording()
                 }
                 else{
+                    audioApp.stopRecording()
                     Material.background = "green"
                     text = "Call"
                     textfield.clear()
@@ -1,16 +1,65 @@
 #include <QGuiApplication>
+#include <QElapsedTimer>
 #include <QQmlApplicationEngine>
+#include <QQmlContext>
+#include <QQuickWindow>
+#include <QTimer>
 #include "AudioApp.h"
+#include "webRTC.h"
 
 int main(int argc, char *argv[]) {
+    // Startup metrics are measured from here
+    QElapsedTimer startupTimer;
+    startupTimer.start();
+
     QGuiApplication app(argc, argv);
 
-    // Create an instance of the AudioApp class
+    // With PHONECALL_STARTUP_BENCHMARK set, a call starts as soon as the UI is up
+    // and the app exits after the first encoded frame, printing both timings on one
+    // STARTUP_METRICS line for the StartupBenchmark tool. It fails if no frame comes in time.
+    const bool startupBenchmark = qEnvironmentVariableIsSet("PHONECALL_STARTUP_BENCHMARK");
+    constexpr int kBenchmarkTimeoutMs = 10000;
+    qint64 timeToInteractive = -1;
+    if (startupBenchmark) {
+        QTimer::singleShot(kBenchmarkTimeoutMs, &app, [&app]() {
+            qWarning() << "Startup benchmark: no frame encoded within" << kBenchmarkTimeoutMs << "ms";
+            app.exit(1);
+        });
+    }
+
+    // Create an instance of the AudioApp class; devices and codecs are set up when a call starts
     AudioApp audioApp;
-    audioApp.startRecording();
 
-    // Load the main.qml file
+    // WebRTC endpoint; its call statistics are shown in the UI
+    WebRTC webRTC;
+    webRTC.init();
+    webRTC.setEncoderStatsProvider([&audioApp]() { return audioApp.encoderStats(); });
+
+    QObject::connect(&audioApp, &AudioApp::firstFrameEncoded, &app, [&]() {
+        const qint64 timeToFirstFrame = startupTimer.elapsed();
+        qInfo() << "Time to first frame:" << timeToFirstFrame << "ms";
+        if (startupBenchmark) {
+            qInfo().noquote() << QStringLiteral("STARTUP_METRICS interactive_ms=%1 first_frame_ms=%2")
+                                     .arg(timeToInteractive).arg(timeToFirstFrame);
+            app.quit();
+        }
+    });
+
+    // Load the main.qml file; the UI comes up before any audio device is touched
     QQmlApplicationEngine engine;
+    engine.rootContext()->setContextProperty("webRTC", &webRTC);
+    engine.rootContext()->setContextProperty("audioApp", &audioApp);
+    QObject::connect(&engine, &QQmlApplicationEngine::objectCreated, &app, [&](QObject *object) {
+        auto *window = qobject_cast<QQuickWindow *>(object);
+        if (!window)
+            return;
+        QObject::connect(window, &QQuickWindow::frameSwapped, &app, [&]() {
+            timeToInteractive = startupTimer.elapsed();
+            qInfo() << "Time to interactive:" << timeToInteractive << "ms";
+            if (startupBenchmark)
+                audioApp.startRecording();
+        }, Qt::SingleShotConnection);
+    });
     engine.load(QUrl(QStringLiteral("qrc:/main.qml")));
 
     // Check for errors in loading QML